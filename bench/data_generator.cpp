@@ -0,0 +1,92 @@
+#include "data_generator.h"
+#include "utils/utils.h"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <random>
+
+namespace bench {
+
+namespace {
+
+// Skewed rank in [0, vocabulary): cubing a uniform draw favours low ranks
+size_t skewedRank(std::mt19937& rng, size_t vocabulary) {
+    double u = std::uniform_real_distribution<double>(0.0, 1.0)(rng);
+    return std::min(vocabulary - 1, static_cast<size_t>(vocabulary * u * u * u));
+}
+
+} // namespace
+
+DataGenerator::DataGenerator(const GeneratorConfig& config) : config(config) {}
+
+std::string DataGenerator::basicId(size_t index) {
+    return "food_" + std::to_string(index);
+}
+
+std::string DataGenerator::compositeId(int level, size_t index) {
+    return "meal_" + std::to_string(level) + "_" + std::to_string(index);
+}
+
+std::string DataGenerator::keyword(size_t rank) {
+    return "kw" + std::to_string(rank);
+}
+
+void DataGenerator::writeCatalog(const std::string& dataDirectory) const {
+    std::filesystem::create_directories(dataDirectory);
+    std::mt19937 rng(config.seed);
+
+    std::ofstream basic(dataDirectory + "/basic_foods.txt");
+    for (size_t i = 0; i < config.basicFoods; ++i) {
+        basic << basicId(i) << "|" << 20 + rng() % 500 << "|";
+        for (size_t k = 0; k < config.keywordsPerFood; ++k) {
+            if (k > 0) basic << ",";
+            basic << keyword(skewedRank(rng, config.keywordVocabulary));
+        }
+        basic << "\n";
+    }
+
+    std::ofstream composite(dataDirectory + "/composite_foods.txt");
+    std::uniform_int_distribution<size_t> anyBasic(0, config.basicFoods - 1);
+    for (int level = 1; level <= config.compositeDepth; ++level) {
+        for (size_t i = 0; i < config.compositesPerLevel; ++i) {
+            composite << compositeId(level, i) << "|meal,level" << level << ","
+                      << keyword(skewedRank(rng, config.keywordVocabulary)) << "\n";
+            if (level == 1) {
+                composite << basicId(i == 0 ? 0 : anyBasic(rng)) << "|" << 1 + rng() % 3 << "\n";
+            } else {
+                composite << compositeId(level - 1, i) << "|1\n";
+                composite << compositeId(level - 1, (i + 1) % config.compositesPerLevel) << "|1\n";
+            }
+            for (int extra = 0; extra < 3; ++extra) {
+                composite << basicId(anyBasic(rng)) << "|" << 1 + rng() % 3 << "\n";
+            }
+            composite << "---\n";
+        }
+    }
+}
+
+std::vector<std::string> DataGenerator::writeLogs(const std::string& logDirectory, const std::string& username,
+                                                  const std::string& lastDate) const {
+    std::string userDirectory = logDirectory + "/" + username;
+    std::filesystem::create_directories(userDirectory);
+    std::mt19937 rng(config.seed + 1);
+    std::uniform_int_distribution<size_t> anyBasic(0, config.basicFoods - 1);
+
+    std::vector<std::string> dates;
+    int last = utils::toDayNumber(lastDate);
+    int first = last - 365 * config.logYears + 1;
+    for (int day = first; day <= last; ++day) {
+        std::string date = utils::fromDayNumber(day);
+        dates.push_back(date);
+        std::ofstream file(userDirectory + "/" + date + ".log");
+        for (int i = 0; i < config.entriesPerDay; ++i) {
+            bool composite = config.compositeDepth > 0 && rng() % 5 == 0;
+            file << (composite ? compositeId(1 + rng() % config.compositeDepth, rng() % config.compositesPerLevel)
+                               : basicId(anyBasic(rng)))
+                 << "|" << 1 + rng() % 3 << "|" << static_cast<long long>(day) * 86400 + i * 3600 << "\n";
+        }
+    }
+    return dates;
+}
+
+} // namespace bench
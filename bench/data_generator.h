@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace bench {
+    struct GeneratorConfig {
+        size_t basicFoods = 10000;        // 1k .. 10M
+        size_t keywordVocabulary = 2000;
+        size_t keywordsPerFood = 4;
+        int compositeDepth = 16;          // levels in the composite DAG
+        size_t compositesPerLevel = 8;
+        int logYears = 3;
+        int entriesPerDay = 5;
+        unsigned seed = 42;
+    };
+
+    // Writes deterministic synthetic data in the application's own file formats.
+    // Keyword use is skewed (a few very common terms, a long tail of rare ones)
+    // so match-all and match-any queries see realistic posting list sizes.
+    class DataGenerator {
+    private:
+        GeneratorConfig config;
+
+    public:
+        explicit DataGenerator(const GeneratorConfig& config);
+
+        static std::string basicId(size_t index);
+        // Composite `index` of `level` (1-based); composite 0 of each level
+        // contains composite 0 of the level below, forming a chain of that depth
+        static std::string compositeId(int level, size_t index);
+        static std::string keyword(size_t rank);
+
+        // basic_foods.txt and composite_foods.txt in `dataDirectory`
+        void writeCatalog(const std::string& dataDirectory) const;
+        // One <date>.log per day for `logYears` years ending on `lastDate`
+        std::vector<std::string> writeLogs(const std::string& logDirectory, const std::string& username,
+                                           const std::string& lastDate) const;
+    };
+}
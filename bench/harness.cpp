@@ -0,0 +1,154 @@
+#include "harness.h"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+namespace bench {
+
+namespace {
+
+struct Registration {
+    std::string name;
+    Function function;
+};
+
+struct Result {
+    std::string name;
+    std::uint64_t iterations;
+    double realNs;
+    double cpuNs;
+    std::uint64_t items;
+};
+
+const std::uint64_t MAX_ITERATIONS = 1000000000;
+
+std::vector<Registration>& registry() {
+    static std::vector<Registration> benchmarks;
+    return benchmarks;
+}
+
+std::string jsonEscape(const std::string& text) {
+    std::string out;
+    for (char c : text) {
+        if (c == '"' || c == '\\') out += '\\';
+        out += c;
+    }
+    return out;
+}
+
+void writeJson(std::ostream& out, const std::vector<Result>& results,
+               const std::vector<std::pair<std::string, std::string>>& context) {
+    out << "{\n  \"context\": {\n";
+    for (size_t i = 0; i < context.size(); ++i) {
+        out << "    \"" << jsonEscape(context[i].first) << "\": \"" << jsonEscape(context[i].second) << "\""
+            << (i + 1 < context.size() ? ",\n" : "\n");
+    }
+    out << "  },\n  \"benchmarks\": [\n";
+    out << std::setprecision(10);
+    for (size_t i = 0; i < results.size(); ++i) {
+        const auto& result = results[i];
+        out << "    {\n"
+            << "      \"name\": \"" << jsonEscape(result.name) << "\",\n"
+            << "      \"run_type\": \"iteration\",\n"
+            << "      \"iterations\": " << result.iterations << ",\n"
+            << "      \"real_time\": " << result.realNs / result.iterations << ",\n"
+            << "      \"cpu_time\": " << result.cpuNs / result.iterations << ",\n";
+        if (result.items > 0 && result.realNs > 0) {
+            out << "      \"items_per_second\": " << result.items / (result.realNs / 1e9) << ",\n";
+        }
+        out << "      \"time_unit\": \"ns\"\n"
+            << "    }" << (i + 1 < results.size() ? ",\n" : "\n");
+    }
+    out << "  ]\n}\n";
+}
+
+} // namespace
+
+State::State(std::uint64_t iterations)
+    : iterations(iterations), remaining(iterations), started(false),
+      cpuStart(0), realNs(0.0), cpuNs(0.0), items(0) {}
+
+void State::startTimer() {
+    realStart = Clock::now();
+    cpuStart = std::clock();
+}
+
+void State::stopTimer() {
+    realNs += std::chrono::duration<double, std::nano>(Clock::now() - realStart).count();
+    cpuNs += 1e9 * static_cast<double>(std::clock() - cpuStart) / CLOCKS_PER_SEC;
+}
+
+bool State::keepRunning() {
+    if (!started) {
+        started = true;
+        startTimer();
+    }
+    if (remaining == 0) {
+        stopTimer();
+        return false;
+    }
+    --remaining;
+    return true;
+}
+
+void State::pauseTiming() { stopTimer(); }
+void State::resumeTiming() { startTimer(); }
+void State::setItemsProcessed(std::uint64_t count) { items = count; }
+
+std::uint64_t State::getIterations() const { return iterations; }
+double State::getRealNs() const { return realNs; }
+double State::getCpuNs() const { return cpuNs; }
+std::uint64_t State::getItemsProcessed() const { return items; }
+
+void registerBenchmark(const std::string& name, Function function) {
+    registry().push_back({name, std::move(function)});
+}
+
+int runBenchmarks(const std::string& filter, double minTime, const std::string& jsonPath,
+                  const std::vector<std::pair<std::string, std::string>>& context) {
+    std::vector<Result> results;
+    std::cout << std::left << std::setw(48) << "Benchmark" << std::right << std::setw(16) << "Time"
+              << std::setw(16) << "CPU" << std::setw(14) << "Iterations" << "\n"
+              << std::string(94, '-') << "\n";
+
+    for (const auto& benchmark : registry()) {
+        if (!filter.empty() && benchmark.name.find(filter) == std::string::npos) continue;
+
+        // Same scheme as Google Benchmark: grow the count until the run is long enough
+        std::uint64_t iterations = 1;
+        State state(iterations);
+        while (true) {
+            state = State(iterations);
+            benchmark.function(state);
+            double seconds = state.getRealNs() / 1e9;
+            if (seconds >= minTime || iterations >= MAX_ITERATIONS) break;
+            double multiplier = seconds > 0 ? 1.4 * minTime / seconds : 10.0;
+            multiplier = std::min(std::max(multiplier, 2.0), 10.0);
+            iterations = std::min<std::uint64_t>(MAX_ITERATIONS,
+                                                 static_cast<std::uint64_t>(iterations * multiplier) + 1);
+        }
+
+        Result result{benchmark.name, state.getIterations(), state.getRealNs(), state.getCpuNs(),
+                      state.getItemsProcessed()};
+        results.push_back(result);
+        std::cout << std::left << std::setw(48) << result.name << std::right << std::fixed
+                  << std::setprecision(1) << std::setw(13) << result.realNs / result.iterations << " ns"
+                  << std::setw(13) << result.cpuNs / result.iterations << " ns"
+                  << std::setw(14) << result.iterations << "\n" << std::defaultfloat;
+    }
+
+    if (!jsonPath.empty()) {
+        std::ofstream file(jsonPath);
+        if (!file.is_open()) {
+            std::cerr << "Could not open " << jsonPath << " for writing\n";
+            return 1;
+        }
+        writeJson(file, results, context);
+    }
+    return 0;
+}
+
+} // namespace bench
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace bench {
+    // Per-run state handed to a benchmark body, modelled on Google Benchmark:
+    //
+    //     while (state.keepRunning()) { ...measured work... }
+    //
+    // Setup that must not be measured goes between pauseTiming()/resumeTiming().
+    class State {
+    private:
+        using Clock = std::chrono::steady_clock;
+
+        std::uint64_t iterations;
+        std::uint64_t remaining;
+        bool started;
+        Clock::time_point realStart;
+        std::clock_t cpuStart;
+        double realNs;
+        double cpuNs;
+        std::uint64_t items;
+
+        void startTimer();
+        void stopTimer();
+
+    public:
+        explicit State(std::uint64_t iterations);
+
+        bool keepRunning();
+        void pauseTiming();
+        void resumeTiming();
+        // Items processed over the whole run, reported as items_per_second
+        void setItemsProcessed(std::uint64_t count);
+
+        std::uint64_t getIterations() const;
+        double getRealNs() const;
+        double getCpuNs() const;
+        std::uint64_t getItemsProcessed() const;
+    };
+
+    using Function = std::function<void(State&)>;
+
+    void registerBenchmark(const std::string& name, Function function);
+
+    // Runs every registered benchmark whose name contains `filter`, growing the
+    // iteration count until a run takes at least `minTime` seconds. Writes a
+    // table to stdout and, when `jsonPath` is not empty, Google Benchmark
+    // compatible JSON so results from different commits can be compared.
+    int runBenchmarks(const std::string& filter, double minTime, const std::string& jsonPath,
+                      const std::vector<std::pair<std::string, std::string>>& context);
+}
@@ -0,0 +1,391 @@
+#include "harness.h"
+#include "data_generator.h"
+#include "database/database.h"
+#include "logger/logger.h"
+#include "utils/calorie_kernel.h"
+#include "utils/signature_kernel.h"
+#include "utils/utils.h"
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+
+namespace {
+
+struct Options {
+    bench::GeneratorConfig generator;
+    std::string filter;
+    std::string jsonPath;
+    std::string workDirectory;
+    double minTime = 0.2;
+};
+
+// Paths of one generated data set; the benchmarks share it
+struct Fixture {
+    std::string dataDirectory;
+    std::string basicFile;
+    std::string compositeFile;
+    std::string snapshotFile;
+    std::string journalFile;
+    std::string logDirectory;
+    std::vector<std::string> logDates;
+    bench::GeneratorConfig config;
+    const bench::DataGenerator* generator;
+};
+
+const char* USERNAME = "bench";
+
+void removeDerivedFiles(const Fixture& fixture) {
+    std::filesystem::remove(fixture.snapshotFile);
+    std::filesystem::remove(fixture.journalFile);
+}
+
+void registerDatabaseBenchmarks(const Fixture& fixture) {
+    // Cold start from the text files (includes writing the snapshot, as the app does)
+    bench::registerBenchmark("BM_DatabaseLoad/text", [&fixture](bench::State& state) {
+        while (state.keepRunning()) {
+            state.pauseTiming();
+            removeDerivedFiles(fixture);
+            state.resumeTiming();
+            Database database(fixture.basicFile, fixture.compositeFile);
+        }
+    });
+
+    bench::registerBenchmark("BM_DatabaseLoad/snapshot", [&fixture](bench::State& state) {
+        { Database warm(fixture.basicFile, fixture.compositeFile); }
+        while (state.keepRunning()) {
+            Database database(fixture.basicFile, fixture.compositeFile);
+        }
+    });
+
+    // Full rewrite of the text files and snapshot
+    bench::registerBenchmark("BM_DatabaseSave/compact", [&fixture](bench::State& state) {
+        Database database(fixture.basicFile, fixture.compositeFile);
+        while (state.keepRunning()) {
+            database.compact();
+        }
+    });
+
+    // One new food made durable through the journal
+    bench::registerBenchmark("BM_DatabaseSave/journal", [&fixture](bench::State& state) {
+        Database database(fixture.basicFile, fixture.compositeFile);
+        size_t next = 0;
+        while (state.keepRunning()) {
+            database.addBasicFood("bench_added_" + std::to_string(next++), {"bench", "added"}, 100);
+            database.save();
+        }
+        // Put back the generated catalog (save() may have compacted into it)
+        state.pauseTiming();
+        removeDerivedFiles(fixture);
+        fixture.generator->writeCatalog(fixture.dataDirectory);
+        state.resumeTiming();
+    });
+}
+
+void registerSearchBenchmarks(const Fixture& fixture, std::shared_ptr<Database> database) {
+    struct Query {
+        const char* name;
+        std::vector<std::string> keywords;
+        bool matchAll;
+    };
+    std::vector<Query> queries = {
+        {"match_all/common", {bench::DataGenerator::keyword(0), bench::DataGenerator::keyword(1)}, true},
+        {"match_all/three", {bench::DataGenerator::keyword(0), bench::DataGenerator::keyword(1),
+                             bench::DataGenerator::keyword(2)}, true},
+        {"match_all/rare", {bench::DataGenerator::keyword(0),
+                            bench::DataGenerator::keyword(fixture.config.keywordVocabulary - 1)}, true},
+        {"match_any/common", {bench::DataGenerator::keyword(0), bench::DataGenerator::keyword(1)}, false},
+        {"match_any/rare", {bench::DataGenerator::keyword(fixture.config.keywordVocabulary / 2),
+                            bench::DataGenerator::keyword(fixture.config.keywordVocabulary - 1)}, false},
+        {"match_any/mixed", {bench::DataGenerator::keyword(0), bench::DataGenerator::keyword(1),
+                             bench::DataGenerator::keyword(fixture.config.keywordVocabulary / 2),
+                             bench::DataGenerator::keyword(fixture.config.keywordVocabulary - 1)}, false},
+    };
+    for (const auto& query : queries) {
+        bench::registerBenchmark(std::string("BM_SearchAllFoods/") + query.name,
+                                 [database, query](bench::State& state) {
+            size_t found = 0;
+            while (state.keepRunning()) {
+                found += database->searchAllFoods(query.keywords, query.matchAll).size();
+            }
+            state.setItemsProcessed(found);
+        });
+        bench::registerBenchmark(std::string("BM_MatchFoods/") + query.name, [database, query](bench::State& state) {
+            size_t found = 0;
+            while (state.keepRunning()) {
+                for (FoodHandle handle : database->matchFoods(query.keywords, query.matchAll)) {
+                    found += handle != INVALID_FOOD_HANDLE;
+                }
+            }
+            state.setItemsProcessed(found);
+        });
+        bench::registerBenchmark(std::string("BM_SearchRanked/") + query.name + "/top:10",
+                                 [database, query](bench::State& state) {
+            size_t found = 0;
+            while (state.keepRunning()) {
+                found += database->searchRanked(query.keywords, query.matchAll, 10).foods.size();
+            }
+            state.setItemsProcessed(found);
+        });
+    }
+}
+
+void registerCalorieBenchmarks(const Fixture& fixture, std::shared_ptr<Database> database) {
+    // Changing food_0 invalidates composite 0 of every level, so each iteration
+    // re-resolves a chain of the given depth
+    for (int depth = 1; depth <= fixture.config.compositeDepth; depth *= 2) {
+        bench::registerBenchmark("BM_CompositeCalories/depth:" + std::to_string(depth),
+                                 [database, depth](bench::State& state) {
+            auto composite = database->getCompositeFood(bench::DataGenerator::compositeId(depth, 0));
+            auto leaf = database->getBasicFood(bench::DataGenerator::basicId(0));
+            double calories = leaf->getCaloriesPerServing();
+            double total = 0.0;
+            while (state.keepRunning()) {
+                leaf->setCaloriesPerServing(calories += 1.0);
+                total += composite->calculateCalories(1);
+            }
+            if (total < 0) std::cout << total;
+        });
+    }
+
+    bench::registerBenchmark("BM_CompositeCalories/cached", [database, &fixture](bench::State& state) {
+        auto composite = database->getCompositeFood(
+            bench::DataGenerator::compositeId(fixture.config.compositeDepth, 0));
+        double total = 0.0;
+        while (state.keepRunning()) {
+            total += composite->calculateCalories(1);
+        }
+        if (total < 0) std::cout << total;
+    });
+}
+
+void registerLoggerBenchmarks(const Fixture& fixture, std::shared_ptr<Database> database) {
+    auto logger = std::make_shared<Logger>(fixture.logDirectory, USERNAME, *database);
+    const auto& dates = fixture.logDates;
+
+    bench::registerBenchmark("BM_LoggerAddEntry", [&fixture, database](bench::State& state) {
+        Logger logger(fixture.logDirectory, "bench_writer", *database);
+        FoodHandle food = database->findFood(bench::DataGenerator::basicId(0));
+        size_t day = 0;
+        while (state.keepRunning()) {
+            logger.addEntry(fixture.logDates[day++ % fixture.logDates.size()], food, 1);
+        }
+        state.pauseTiming();
+        std::filesystem::remove_all(fixture.logDirectory + "/bench_writer");
+        state.resumeTiming();
+    });
+
+    // First access to a day reads its file
+    bench::registerBenchmark("BM_LoggerGetLog/cold", [&fixture, database](bench::State& state) {
+        std::unique_ptr<Logger> cold;
+        size_t day = 0;
+        while (state.keepRunning()) {
+            state.pauseTiming();
+            if (day % fixture.logDates.size() == 0) {
+                cold = std::make_unique<Logger>(fixture.logDirectory, USERNAME, *database);
+            }
+            state.resumeTiming();
+            cold->getLog(fixture.logDates[day++ % fixture.logDates.size()]);
+        }
+    });
+
+    bench::registerBenchmark("BM_LoggerGetLog/cached", [logger, &dates](bench::State& state) {
+        size_t day = 0, entries = 0;
+        while (state.keepRunning()) {
+            entries += logger->getLog(dates[day++ % dates.size()]).size();
+        }
+        state.setItemsProcessed(entries);
+    });
+
+    bench::registerBenchmark("BM_LoggerTotalCalories", [logger, &dates](bench::State& state) {
+        size_t day = 0;
+        double total = 0.0;
+        while (state.keepRunning()) {
+            total += logger->calculateTotalCalories(dates[day++ % dates.size()]);
+        }
+        if (total < 0) std::cout << total;
+    });
+
+    bench::registerBenchmark("BM_LoggerSummarizeRange/month", [logger, &dates](bench::State& state) {
+        while (state.keepRunning()) {
+            logger->summarizeRange(dates.front(), dates.back(), SummaryPeriod::MONTH);
+        }
+    });
+
+    // Every day of the range is totalled from the history on each iteration
+    bench::registerBenchmark("BM_LoggerSummarizeRange/day:cold", [&fixture, database](bench::State& state) {
+        const auto& dates = fixture.logDates;
+        while (state.keepRunning()) {
+            state.pauseTiming();
+            Logger cold(fixture.logDirectory, USERNAME, *database);
+            state.resumeTiming();
+            cold.summarizeRange(dates.front(), dates.back(), SummaryPeriod::DAY);
+        }
+    });
+}
+
+// Row and per-day reductions over synthetic columns: 64k rows, ~8 per day;
+// then a two-keyword signature filter over 64k foods of four keywords each
+void registerKernelBenchmarks() {
+    const size_t rows = 1 << 16;
+    const size_t foodCount = 10000;
+    auto table = std::make_shared<std::vector<double>>(foodCount);
+    auto foods = std::make_shared<std::vector<std::uint32_t>>(rows);
+    auto servings = std::make_shared<std::vector<std::int32_t>>(rows);
+    auto offsets = std::make_shared<std::vector<std::uint32_t>>();
+    std::mt19937 random(42);
+    for (auto& calories : *table) calories = random() % 1000;
+    for (size_t row = 0; row < rows; ++row) {
+        (*foods)[row] = random() % foodCount;
+        (*servings)[row] = 1 + random() % 4;
+    }
+    for (size_t row = 0; row < rows; row += 4 + random() % 9) {
+        offsets->push_back(static_cast<std::uint32_t>(row));
+    }
+    offsets->push_back(static_cast<std::uint32_t>(rows));
+
+    std::vector<const utils::CalorieKernel*> kernels = {&utils::scalarCalorieKernel()};
+    if (&utils::calorieKernel() != kernels[0]) kernels.push_back(&utils::calorieKernel());
+    for (const utils::CalorieKernel* kernel : kernels) {
+        std::string name = kernel->name;
+        bench::registerBenchmark("BM_CalorieKernel/rows/" + name, [=](bench::State& state) {
+            double total = 0.0;
+            while (state.keepRunning()) {
+                total += kernel->sum(table->data(), foods->data(), servings->data(), rows);
+            }
+            state.setItemsProcessed(state.getIterations() * rows);
+            if (total < 0) std::cout << total;
+        });
+        bench::registerBenchmark("BM_CalorieKernel/days/" + name, [=](bench::State& state) {
+            std::vector<double> days(offsets->size() - 1);
+            while (state.keepRunning()) {
+                kernel->sumByDay(table->data(), foods->data(), servings->data(), offsets->data(), days.size(),
+                                 days.data());
+            }
+            state.setItemsProcessed(state.getIterations() * rows);
+            if (days[0] < 0) std::cout << days[0];
+        });
+    }
+
+    auto signatures = std::make_shared<std::vector<std::uint64_t>>(rows);
+    auto wordBit = [&random] { return std::uint64_t(1) << (random() % 64); };
+    for (auto& signature : *signatures) {
+        signature = 0;
+        for (int bit = 0; bit < 8; ++bit) signature |= wordBit();
+    }
+    std::uint64_t query = wordBit() | wordBit() | wordBit() | wordBit();
+    std::vector<const utils::SignatureKernel*> filters = {&utils::scalarSignatureKernel()};
+    if (&utils::signatureKernel() != filters[0]) filters.push_back(&utils::signatureKernel());
+    for (const utils::SignatureKernel* kernel : filters) {
+        bench::registerBenchmark(std::string("BM_SignatureKernel/") + kernel->name, [=](bench::State& state) {
+            std::vector<std::uint32_t> out(rows);
+            size_t found = 0;
+            while (state.keepRunning()) {
+                found += kernel->select(signatures->data(), rows, query, 0, out.data());
+            }
+            state.setItemsProcessed(state.getIterations() * rows);
+            if (found == 1) std::cout << found;
+        });
+    }
+}
+
+void registerPasswordBenchmarks() {
+    bench::registerBenchmark("BM_VerifyPassword", [](bench::State& state) {
+        std::string hash = utils::hashPassword("correct horse battery staple");
+        bool ok = true;
+        while (state.keepRunning()) {
+            ok &= utils::verifyPassword("correct horse battery staple", hash);
+        }
+        if (!ok) std::cout << "password mismatch\n";
+    });
+}
+
+void printUsage(const char* program) {
+    std::cerr << "Usage: " << program << " [--foods N] [--depth N] [--years N] [--filter TEXT]\n"
+              << "       [--min-time SECONDS] [--json FILE] [--work-dir DIR]\n";
+}
+
+bool parseOptions(int argc, char* argv[], Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) return false;
+        std::string value = argv[++i];
+        if (arg == "--foods") options.generator.basicFoods = std::stoull(value);
+        else if (arg == "--depth") options.generator.compositeDepth = std::stoi(value);
+        else if (arg == "--years") options.generator.logYears = std::stoi(value);
+        else if (arg == "--filter") options.filter = value;
+        else if (arg == "--min-time") options.minTime = std::stod(value);
+        else if (arg == "--json") options.jsonPath = value;
+        else if (arg == "--work-dir") options.workDirectory = value;
+        else return false;
+    }
+    return options.generator.basicFoods >= options.generator.compositesPerLevel &&
+           options.generator.compositeDepth >= 1 && options.generator.logYears >= 1;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Options options;
+    try {
+        if (!parseOptions(argc, argv, options)) {
+            printUsage(argv[0]);
+            return 1;
+        }
+    } catch (const std::exception&) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    std::string root = options.workDirectory.empty()
+        ? (std::filesystem::temp_directory_path() / ("yada_bench_" + std::to_string(std::random_device{}()))).string()
+        : options.workDirectory;
+
+    Fixture fixture;
+    fixture.config = options.generator;
+    fixture.dataDirectory = root + "/data";
+    fixture.basicFile = fixture.dataDirectory + "/basic_foods.txt";
+    fixture.compositeFile = fixture.dataDirectory + "/composite_foods.txt";
+    fixture.snapshotFile = fixture.dataDirectory + "/foods.snapshot";
+    fixture.journalFile = fixture.dataDirectory + "/foods.journal";
+    fixture.logDirectory = fixture.dataDirectory + "/daily_logs";
+
+    std::cerr << "Generating " << options.generator.basicFoods << " foods, depth "
+              << options.generator.compositeDepth << ", " << options.generator.logYears
+              << " years of logs in " << root << "\n";
+    bench::DataGenerator generator(options.generator);
+    fixture.generator = &generator;
+    generator.writeCatalog(fixture.dataDirectory);
+    fixture.logDates = generator.writeLogs(fixture.logDirectory, USERNAME, utils::getCurrentDate());
+
+    {
+        auto database = std::make_shared<Database>(fixture.basicFile, fixture.compositeFile);
+        registerDatabaseBenchmarks(fixture);
+        registerSearchBenchmarks(fixture, database);
+        registerCalorieBenchmarks(fixture, database);
+        registerLoggerBenchmarks(fixture, database);
+        registerKernelBenchmarks();
+        registerPasswordBenchmarks();
+
+        std::vector<std::pair<std::string, std::string>> context = {
+            {"date", utils::getCurrentDate()},
+            {"executable", argv[0]},
+            {"basic_foods", std::to_string(options.generator.basicFoods)},
+            {"composite_depth", std::to_string(options.generator.compositeDepth)},
+            {"log_years", std::to_string(options.generator.logYears)},
+#ifdef NDEBUG
+            {"library_build_type", "release"},
+#else
+            {"library_build_type", "debug"},
+#endif
+        };
+        int status = bench::runBenchmarks(options.filter, options.minTime, options.jsonPath, context);
+        if (status != 0) return status;
+    }
+
+    if (options.workDirectory.empty()) {
+        std::filesystem::remove_all(root);
+    }
+    return 0;
+}
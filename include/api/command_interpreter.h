@@ -0,0 +1,52 @@
+#pragma once
+
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <vector>
+#include "api/yada_service.h"
+
+// Text request grammar shared by batch mode and the session server: one
+// command per line, arguments separated by whitespace and optionally
+// double-quoted. Covers the same operations as the interactive menus.
+class CommandInterpreter {
+private:
+    YadaService& service;
+    std::shared_ptr<UserSession> session;
+    std::string currentDate;
+    // Batch scripts hold log writes until commit(); the server writes through
+    bool holdWrites;
+    // Whether commands may name local paths (import-logs, export-logs). The
+    // server refuses them: a path would be resolved on the server's file
+    // system with its permissions, not the client's.
+    bool fileAccess;
+    // The last ranked search, which `more` continues
+    struct RankedQuery {
+        std::vector<std::string> keywords;
+        bool matchAll = false;
+        KeywordMatch match = KeywordMatch::EXACT;
+        size_t limit = 0;
+        SearchCursor next;
+        bool more = false;
+    };
+    RankedQuery rankedQuery;
+
+    bool requireUser(std::ostream& out) const;
+    void printLog(const std::string& date, std::ostream& out) const;
+    void printRankedPage(std::ostream& out);
+    void printReport(const std::string& from, const std::string& to, SummaryPeriod period, std::ostream& out);
+
+public:
+    CommandInterpreter(YadaService& service, bool holdWrites, bool fileAccess);
+
+    // Splits a request line; empty for blank lines and "#" comments
+    static std::vector<std::string> tokenize(const std::string& line);
+    // Runs one request, writing its user-facing output; false if it failed
+    bool execute(const std::vector<std::string>& args, std::ostream& out);
+    // Makes held log writes durable
+    void commit();
+    // Ends the current session, if any, saving its logs
+    void logout();
+
+    static const char* help();
+};
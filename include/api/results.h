@@ -0,0 +1,75 @@
+#pragma once
+
+#include <ctime>
+#include <string>
+#include <utility>
+#include <vector>
+#include "logger/logger.h"
+
+// Outcome of an API call that produces no value; `error` is a user-facing message
+struct Status {
+    bool ok;
+    std::string error;
+
+    static Status success() { return {true, ""}; }
+    static Status failure(const std::string& error) { return {false, error}; }
+};
+
+// Outcome of an API call that produces a value (left default-constructed on failure)
+template <typename T>
+struct Result {
+    bool ok;
+    std::string error;
+    T value;
+
+    static Result success(T value) { return {true, "", std::move(value)}; }
+    static Result failure(const std::string& error) { return {false, error, T()}; }
+};
+
+struct FoodComponentInfo {
+    std::string foodId;
+    int servings;
+};
+
+struct FoodInfo {
+    std::string id;
+    bool composite;
+    std::vector<std::string> keywords;
+    double caloriesPerServing;
+    std::vector<FoodComponentInfo> components;
+};
+
+// One page of ranked search results, best first; pass `next` back for the
+// page after it
+struct FoodPage {
+    std::vector<FoodInfo> foods;
+    SearchCursor next;
+    bool more = false;
+};
+
+// One entry of a day's log; `index` is its position for removeEntry()
+struct LogItem {
+    size_t index;
+    bool defined;   // false once the food has been removed from the database
+    std::string foodId;
+    int servings;
+    double calories;
+    std::time_t timestamp;
+};
+
+struct DailySummary {
+    std::string date;
+    double consumedCalories;
+    double targetCalories;
+
+    double difference() const { return consumedCalories - targetCalories; }
+};
+
+struct RangeReport {
+    std::vector<CalorieSummary> periods;
+    double totalCalories;
+    int days;
+    double targetCalories;
+
+    double averageCalories() const { return days > 0 ? totalCalories / days : 0.0; }
+};
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+#include "api/results.h"
+#include "database/database.h"
+#include "logger/logger.h"
+#include "user/user.h"
+
+// A logged-in user's view of the engine: log edits, undo/redo and calorie
+// summaries. Obtained from YadaService::login(); nothing here prints.
+class UserSession {
+private:
+    // Replaced wholesale on profile updates; read with std::atomic_load
+    std::shared_ptr<const User> user;
+    Database& database;
+    Logger logger;
+
+public:
+    UserSession(std::shared_ptr<const User> user, Database& database, const std::string& logDirectory);
+
+    std::shared_ptr<const User> getUser() const;
+    void setUser(std::shared_ptr<const User> updated);
+
+    // Log mutation
+    Status addEntry(const std::string& date, const std::string& foodId, int servings);
+    Status removeEntry(const std::string& date, size_t index);
+    Status undo();
+    Status redo();
+
+    // Queries
+    Result<std::vector<LogItem>> getLog(const std::string& date) const;
+    Result<DailySummary> summarize(const std::string& date) const;
+    Result<RangeReport> report(const std::string& from, const std::string& to, SummaryPeriod period);
+
+    // Persistence: batch mode holds log writes until flush(); save() also
+    // folds the operation log into the history
+    void setBatchMode(bool enabled);
+    void flush();
+    void save();
+
+    // Copies days from / to a directory of <YYYY-MM-DD>.log files; the
+    // result is the number of days copied
+    Result<size_t> importLogs(const std::string& directory);
+    Result<size_t> exportLogs(const std::string& directory);
+};
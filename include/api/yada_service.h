@@ -0,0 +1,76 @@
+#pragma once
+
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "api/results.h"
+#include "api/user_session.h"
+#include "database/database.h"
+#include "user/user.h"
+
+// Non-interactive entry point to the engine: accounts, the food database and
+// per-user sessions. Every call returns a structured result and never prints,
+// so the CLI, batch mode and embedding services share the same behaviour.
+// Safe to call from several threads at once.
+class YadaService {
+private:
+    std::string dataDirectory;
+    std::string usersFile;
+    std::string logDirectory;
+    std::unique_ptr<Database> database;
+    // Guards users and warmSessions
+    mutable std::mutex mutex;
+    std::map<std::string, std::shared_ptr<const User>> users;
+    // Recently used sessions, most recent first. Logging in again reuses the
+    // session and its loaded logs instead of re-reading the user's files.
+    std::list<std::shared_ptr<UserSession>> warmSessions;
+    size_t sessionCacheSize;
+    bool batchMode;
+
+    void loadUsers();
+    void saveUsers() const;
+    void trimSessions();
+    FoodInfo describeFood(FoodHandle food) const;
+
+public:
+    static constexpr size_t DEFAULT_SESSION_CACHE = 16;
+
+    explicit YadaService(const std::string& dataDirectory = "data");
+    // Saves every warm session
+    ~YadaService();
+    YadaService(const YadaService&) = delete;
+    YadaService& operator=(const YadaService&) = delete;
+
+    // Accounts
+    Result<std::shared_ptr<UserSession>> login(const std::string& username, const std::string& password);
+    Status registerUser(const std::string& username, const std::string& password,
+                        Gender gender, double height, int age, double weight,
+                        ActivityLevel activityLevel);
+    Status updateProfile(const std::string& username, double height, int age, double weight,
+                         ActivityLevel activityLevel);
+    bool userExists(const std::string& username) const;
+    // Sessions still in use are never evicted, so the cache may briefly exceed `size`
+    void setSessionCacheSize(size_t size);
+
+    // Foods
+    Status addBasicFood(const std::string& id, const std::vector<std::string>& keywords, double calories);
+    Status addCompositeFood(const std::string& id, const std::vector<std::string>& keywords,
+                            const std::vector<FoodComponentInfo>& components);
+    bool foodExists(const std::string& id) const;
+    Result<FoodInfo> getFood(const std::string& id) const;
+    std::vector<FoodInfo> searchFoods(const std::vector<std::string>& keywords, bool matchAll,
+                                      KeywordMatch match = KeywordMatch::EXACT) const;
+    // The `limit` foods after `after` that match best, rarer keywords counting for more
+    FoodPage searchFoodsRanked(const std::vector<std::string>& keywords, bool matchAll, size_t limit,
+                               const SearchCursor& after = SearchCursor(),
+                               KeywordMatch match = KeywordMatch::EXACT) const;
+
+    // Food changes are saved as they are made unless batch mode holds them for commit()
+    void setBatchMode(bool enabled);
+    void commit();
+
+    Database& getDatabase();
+};
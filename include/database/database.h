@@ -1,45 +1,290 @@
 #pragma once
 
+#include <atomic>
+#include <cstdint>
+#include <limits>
 #include <string>
+#include <string_view>
 #include <vector>
+#include <deque>
+#include <iterator>
 #include <map>
 #include <memory>
+#include <mutex>
+#include "database/food_catalog.h"
+#include "database/keyword_trie.h"
 #include "food/food.h"
 #include "food/basic_food.h"
 #include "food/composite_food.h"
+#include "utils/epoch.h"
 
+// How a query keyword is compared with food keywords
+enum class KeywordMatch {
+    EXACT,   // the whole keyword, ignoring case
+    PREFIX,  // any keyword starting with it
+    FUZZY    // any keyword within a few edits (see Database::fuzzyEdits)
+};
+
+// A ranked search hit. The score is the sum of the weights of the query
+// keywords the food matches; a keyword's weight is its inverse document
+// frequency in thousandths, so rare keywords count for more. Scores are
+// integers so that equal scores compare equal however they were summed.
+struct RankedFood {
+    FoodHandle handle;
+    std::uint64_t score;
+};
+
+// Where a ranked page ended: hits rank by score, then by ascending handle,
+// and the next page starts just after this one. The default starts at the top.
+struct SearchCursor {
+    std::uint64_t score = std::numeric_limits<std::uint64_t>::max();
+    FoodHandle handle = INVALID_FOOD_HANDLE;
+};
+
+struct RankedPage {
+    std::vector<RankedFood> foods;
+    SearchCursor next;
+    bool more = false;  // whether another page follows
+};
+
+// Food database shared by every session in the process. Reads never lock:
+// the catalog and keyword indexes live in two identical State copies, one of
+// which is published to readers. A writer applies its change to the standby
+// copy, publishes it, waits for readers of the old copy to leave their epoch
+// sections and then replays the change on the old copy. Writers serialize on
+// a mutex and must not be called while the same thread holds a Reader.
 class Database {
 private:
-    std::map<std::string, std::shared_ptr<BasicFood>> basicFoods;
-    std::map<std::string, std::shared_ptr<CompositeFood>> compositeFoods;
+    // Inverted keyword index: KeywordId -> ascending list of food handles.
+    // Ids are dense, so the index is a plain array; it grows as needed and a
+    // keyword no food of the kind uses has an empty list.
+    using PostingList = std::vector<FoodHandle>;
+    using KeywordIndex = std::vector<PostingList>;
+
+    struct State {
+        FoodCatalog catalog;
+        KeywordIndex basicKeywordIndex;
+        KeywordIndex compositeKeywordIndex;
+        // The keys of each index, for prefix and fuzzy lookups
+        KeywordTrie basicVocabulary;
+        KeywordTrie compositeVocabulary;
+        size_t basicFoodCount = 0;
+        size_t compositeFoodCount = 0;
+
+        FoodHandle defineBasicFood(const std::string& id, const std::vector<std::string>& keywords, double calories);
+        FoodHandle defineCompositeFood(const std::string& id, const std::vector<std::string>& keywords);
+        void forgetDefinition(FoodHandle handle);
+        void setKeywords(FoodHandle handle, const std::vector<std::string>& keywords);
+        FoodHandle findFood(std::string_view id) const;
+    };
+
+    State states[2];
+    std::atomic<State*> published;
+    mutable utils::EpochDomain epochs;
+    // Serializes writers and guards everything below it
+    std::mutex writerMutex;
+
     std::string basicFoodsFile;
     std::string compositeFoodsFile;
+    std::string snapshotFile;
+
+    // Append-only mutation journal, replayed on load and folded into the text
+    // files by compact(). Records are buffered until the next save().
+    std::string journalFile;
+    std::vector<std::string> pendingJournal;
+    size_t journalRecords;
+    size_t journalBytes;
+
+    // Add or remove `handle` under each of its current catalog keywords
+    static void indexFood(KeywordIndex& index, KeywordTrie& vocabulary, const FoodCatalog& catalog,
+                          FoodHandle handle);
+    static void unindexFood(KeywordIndex& index, KeywordTrie& vocabulary, const FoodCatalog& catalog,
+                            FoodHandle handle);
+    // The posting list of one lower-cased query keyword. A keyword that
+    // expands to several vocabulary words gets the union of theirs, kept in
+    // `expanded`; nullptr when nothing matches.
+    static const PostingList* lookupKeyword(const KeywordIndex& index, const KeywordTrie& vocabulary,
+                                            const FoodCatalog& catalog, const std::string& term,
+                                            KeywordMatch match, std::deque<PostingList>& expanded);
+
+    // Applies `mutation` to both copies, publishing the updated one in between;
+    // the caller holds writerMutex
+    template <typename Mutation>
+    void write(Mutation mutation);
+    void checkWriter() const;
 
-    void loadBasicFoods();
-    void loadCompositeFoods();
-    void saveBasicFoods() const;
-    void saveCompositeFoods() const;
+    // Each replaces its text file atomically; false if it could not be written
+    bool saveBasicFoods(const State& state) const;
+    bool saveCompositeFoods(const State& state) const;
+    void replayJournal(State& state);
+    void appendJournal();
+    void compactLocked();
 
 public:
+    // Pins the published catalog for the lifetime of the object. Cheap to
+    // create: one CAS on entry and one store on exit.
+    class Reader {
+    private:
+        utils::EpochDomain::Section section;
+        const State* state;
+
+    public:
+        Reader(utils::EpochDomain::Section section, const State* state);
+
+        const FoodCatalog& catalog() const;
+        // Calorie lookup over the pinned catalog; every row is already resolved
+        CatalogView view() const;
+
+        friend class Database;
+    };
+
+    // Lazy search results, basic foods before composites and each kind in
+    // handle order. Matches are found as the range is walked, a small batch
+    // at a time, straight from the keyword posting lists; nothing is
+    // collected up front, so a caller that stops early skips the rest of the
+    // work. The catalog stays pinned while the range lives, as for a Reader.
+    class Matches {
+    private:
+        // The unread part of one posting list
+        struct Cursor {
+            const FoodHandle* next;
+            const FoodHandle* end;
+        };
+        // The matches of one food kind
+        struct Pass {
+            FoodKind kind;
+            std::vector<Cursor> cursors;  // rarest first for match-all
+            bool everything;              // an empty match-all query
+            FoodHandle scan;              // next handle to try when `everything` or `dense`
+            // Exact match-all over several keywords: the query's ids,
+            // ascending, and their combined signature (0 when unused).
+            // Candidates are tested against food signatures and then
+            // verified against the food's own keywords, so the other lists
+            // are never walked.
+            std::vector<KeywordId> keywords = {};
+            std::uint64_t signature = 0;
+            bool dense = false;           // scan the signature table up to the rarest list's last handle
+        };
+
+        Reader reader;
+        bool matchAll;
+        std::deque<PostingList> expanded;
+        std::vector<Pass> passes;
+        size_t current;
+        // Matches are found a batch at a time so the list walks run in tight
+        // loops; a match-any batch covers a window of this many handles
+        static constexpr size_t BATCH = 256;
+        // The signature table is scanned instead of walking the rarest list
+        // once that list holds at least one in this many of the handles it spans
+        static constexpr size_t DENSE_SCAN_RATIO = 8;
+        FoodHandle batch[BATCH];
+        size_t batchSize;
+        size_t batchPosition;
+
+        Matches(Reader reader, bool matchAll);
+        void addPass(FoodKind kind, const std::vector<std::string>& keywords, KeywordMatch match);
+        // Writes up to BATCH more matches of `pass` to `batch`; 0 once it is exhausted
+        size_t fillBatch(Pass& pass);
+        FoodHandle refill();
+
+    public:
+        // Single-pass input iterator over the remaining matches
+        class iterator {
+        private:
+            Matches* matches;
+            FoodHandle handle;
+
+        public:
+            using iterator_category = std::input_iterator_tag;
+            using value_type = FoodHandle;
+            using difference_type = std::ptrdiff_t;
+            using pointer = const FoodHandle*;
+            using reference = FoodHandle;
+
+            iterator(Matches* matches, FoodHandle handle) : matches(matches), handle(handle) {}
+            FoodHandle operator*() const { return handle; }
+            iterator& operator++() {
+                handle = matches->next();
+                return *this;
+            }
+            bool operator==(const iterator& other) const { return handle == other.handle; }
+            bool operator!=(const iterator& other) const { return handle != other.handle; }
+        };
+
+        // The next match, or INVALID_FOOD_HANDLE once there are no more
+        FoodHandle next() {
+            return batchPosition < batchSize ? batch[batchPosition++] : refill();
+        }
+        iterator begin() { return iterator(this, next()); }
+        iterator end() { return iterator(this, INVALID_FOOD_HANDLE); }
+        // The pinned catalog the matches belong to
+        const FoodCatalog& catalog() const;
+
+        friend class Database;
+    };
+
     Database(const std::string& basicFoodsFile, const std::string& compositeFoodsFile);
+    Database(const Database&) = delete;
+    Database& operator=(const Database&) = delete;
+
+    Reader read() const;
 
     // Basic food operations
     void addBasicFood(const std::string& id, const std::vector<std::string>& keywords, double calories);
-    std::shared_ptr<BasicFood> getBasicFood(const std::string& id) const;
-    std::vector<std::shared_ptr<BasicFood>> searchBasicFoods(const std::vector<std::string>& keywords, bool matchAll = true) const;
+    void setCalories(FoodHandle food, double calories);
+    std::shared_ptr<BasicFood> getBasicFood(const std::string& id);
+    std::vector<std::shared_ptr<BasicFood>> searchBasicFoods(const std::vector<std::string>& keywords, bool matchAll = true,
+                                                             KeywordMatch match = KeywordMatch::EXACT);
 
     // Composite food operations
     void addCompositeFood(const std::string& id, const std::vector<std::string>& keywords);
-    std::shared_ptr<CompositeFood> getCompositeFood(const std::string& id) const;
-    std::vector<std::shared_ptr<CompositeFood>> searchCompositeFoods(const std::vector<std::string>& keywords, bool matchAll = true) const;
+    // Refuses (returns false) unless `food` is defined and does not already contain `composite`
+    bool addComponent(FoodHandle composite, FoodHandle food, int servings);
+    void removeComponent(FoodHandle composite, FoodHandle food);
+    void clearComponents(FoodHandle composite);
+    std::shared_ptr<CompositeFood> getCompositeFood(const std::string& id);
+    std::vector<std::shared_ptr<CompositeFood>> searchCompositeFoods(const std::vector<std::string>& keywords,
+                                                                     bool matchAll = true,
+                                                                     KeywordMatch match = KeywordMatch::EXACT);
+
+    // Handle-based access
+    FoodHandle findFood(const std::string& id) const;
+    // Returns the handle for `id`, adding an undefined row if it is new
+    FoodHandle internFood(std::string_view id);
+    void setKeywords(FoodHandle food, const std::vector<std::string>& keywords);
+    // Lazy forms of the searches; the vector-returning ones collect these
+    Matches matchFoods(const std::vector<std::string>& keywords, bool matchAll = true,
+                       KeywordMatch match = KeywordMatch::EXACT) const;
+    Matches matchFoods(FoodKind kind, const std::vector<std::string>& keywords, bool matchAll = true,
+                       KeywordMatch match = KeywordMatch::EXACT) const;
+    std::vector<FoodHandle> searchFoodHandles(const std::vector<std::string>& keywords, bool matchAll = true,
+                                              KeywordMatch match = KeywordMatch::EXACT) const;
+    // The `limit` best matches ranked by score (see RankedFood) that come
+    // after `after`. Only the page is materialized: once the page is full,
+    // keywords too light to lift a food into it stop producing candidates,
+    // and candidates that cannot beat the page are dropped unscored.
+    RankedPage searchRanked(const std::vector<std::string>& keywords, bool matchAll, size_t limit,
+                            const SearchCursor& after = SearchCursor(),
+                            KeywordMatch match = KeywordMatch::EXACT) const;
+    // Edits a FUZZY query keyword may be from a match: none below three
+    // characters, one below six, otherwise two
+    static int fuzzyEdits(size_t length);
 
     // General operations
-    void save() const;
-    std::vector<std::shared_ptr<Food>> searchAllFoods(const std::vector<std::string>& keywords, bool matchAll = true) const;
-    std::shared_ptr<Food> getFood(const std::string& id) const;
-    std::map<std::string, std::shared_ptr<Food>> getAllFoods() const;
+    static constexpr size_t JOURNAL_COMPACT_RECORDS = 1000;
+    static constexpr size_t JOURNAL_COMPACT_BYTES = 1 << 20;
+
+    // Makes pending changes durable; compacts once the journal passes a threshold
+    void save();
+    // Rewrites the text files and snapshot from memory and empties the journal
+    void compact();
+    std::vector<std::shared_ptr<Food>> searchAllFoods(const std::vector<std::string>& keywords, bool matchAll = true,
+                                                      KeywordMatch match = KeywordMatch::EXACT);
+    std::shared_ptr<Food> getFood(const std::string& id);
 
-    #ifdef DEBUG
+    // Dumps the contents at VERBOSE trace level
     void debugPrint() const;
-    #endif
-}; 
\ No newline at end of file
+
+    friend class CatalogSnapshot;
+    friend class FoodFileLoader;
+};
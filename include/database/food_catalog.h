@@ -0,0 +1,154 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "utils/span.h"
+
+// Dense 4-byte food identifier, valid for the lifetime of the catalog that issued it
+using FoodHandle = std::uint32_t;
+constexpr FoodHandle INVALID_FOOD_HANDLE = std::numeric_limits<FoodHandle>::max();
+
+// Dense identifier of a lower-cased keyword in a catalog's keyword table
+using KeywordId = std::uint32_t;
+constexpr KeywordId INVALID_KEYWORD = std::numeric_limits<KeywordId>::max();
+
+enum class FoodKind : std::uint8_t {
+    UNDEFINED,  // interned name with no definition (e.g. referenced by an old log)
+    BASIC,
+    COMPOSITE
+};
+
+struct FoodComponent {
+    FoodHandle food;
+    int servings;
+};
+
+class CatalogView;
+
+// Interned, structure-of-arrays food table. Every per-food attribute lives in a
+// contiguous array indexed by handle; keywords and components are spans into
+// shared pools so catalog walks touch packed memory only. Keywords are
+// lower-cased and interned once, so each distinct keyword is stored once and
+// a food's keywords are a sorted span of KeywordIds.
+class FoodCatalog {
+private:
+    // Names are packed into one arena; nameOffsets has one extra end sentinel.
+    // Lookup is an open-addressing table of handles, so interning allocates
+    // nothing per food beyond amortized array growth.
+    std::string nameArena;
+    std::vector<std::uint32_t> nameOffsets;
+    std::vector<FoodHandle> slots;
+    std::vector<FoodKind> kinds;
+
+    // Per-serving calories; composite rows are memoized and recomputed on demand
+    mutable std::vector<double> calories;
+    mutable std::vector<std::uint8_t> caloriesValid;
+    // Composites invalidated since the last resolve, and per-row scratch
+    // counters for resolving them in dependency order
+    mutable std::vector<FoodHandle> staleRows;
+    mutable std::vector<std::uint32_t> pendingComponents;
+
+    // Keyword table, laid out like the names: one arena with an end
+    // sentinel offset, and an open-addressing table of ids
+    std::string keywordArena;
+    std::vector<std::uint32_t> keywordTextOffsets;
+    std::vector<KeywordId> keywordSlots;
+
+    // Keyword and component spans (offset, count) into the pools below
+    std::vector<std::uint32_t> keywordOffsets;
+    std::vector<std::uint32_t> keywordCounts;
+    std::vector<KeywordId> keywordPool;
+    // Per-food bloom filter of its keywords (see keywordSignature)
+    std::vector<std::uint64_t> keywordSignatures;
+    std::vector<std::uint32_t> componentOffsets;
+    std::vector<std::uint32_t> componentCounts;
+    std::vector<FoodComponent> componentPool;
+    size_t deadKeywords;
+    size_t deadComponents;
+    // Bumped whenever any food's calories may have changed
+    std::uint64_t calorieRevision;
+
+    // Reverse dependency edges: food -> composites that contain it
+    std::vector<std::vector<FoodHandle>> dependents;
+
+    static std::uint64_t hashName(std::string_view id);
+    size_t findSlot(std::string_view id) const;
+    void rehash(size_t slotCount);
+    size_t findKeywordSlot(std::string_view keyword) const;
+    void rehashKeywords(size_t slotCount);
+    void invalidate(FoodHandle handle);
+    void resolveCalories() const;
+    void removeDependent(FoodHandle food, FoodHandle composite);
+    void compactPools();
+
+public:
+    FoodCatalog();
+
+    // Interning
+    FoodHandle intern(std::string_view id);
+    FoodHandle find(std::string_view id) const;
+    size_t size() const;
+    std::uint64_t revision() const;
+    // Resolves every stale composite, then hands out a branch-free calorie lookup
+    CatalogView view() const;
+
+    // Keyword table. internKeyword() lower-cases `keyword` first; findKeyword()
+    // expects it lower-cased already and returns INVALID_KEYWORD if unknown.
+    // Ids are never reused, so the table only grows.
+    KeywordId internKeyword(std::string_view keyword);
+    KeywordId findKeyword(std::string_view keyword) const;
+    std::string_view keywordText(KeywordId keyword) const;
+    size_t keywordTableSize() const;
+    // The bits `keyword` sets in a food's 64-bit signature. A food can only
+    // have every keyword of a query if its signature has all of theirs.
+    static std::uint64_t keywordSignature(KeywordId keyword);
+
+    // Rows resolved per task when a level of stale composites is spread over the thread pool
+    static constexpr size_t PARALLEL_RESOLVE_ROWS = 4096;
+
+    // Row accessors; the returned name is invalidated by the next intern()
+    std::string_view name(FoodHandle handle) const;
+    FoodKind kind(FoodHandle handle) const;
+    bool isDefined(FoodHandle handle) const;
+    double caloriesPerServing(FoodHandle handle) const;
+    // Ascending and free of duplicates
+    utils::Span<const KeywordId> keywords(FoodHandle handle) const;
+    // Every food's signature, indexed by handle; undefined foods have none set
+    const std::uint64_t* signatureTable() const { return keywordSignatures.data(); }
+    utils::Span<const FoodComponent> components(FoodHandle handle) const;
+    // True if `part` is `food` itself or appears anywhere below it. Adding
+    // `food` as a component of `part` would then create a cycle.
+    bool contains(FoodHandle food, FoodHandle part) const;
+
+    // Definitions
+    void defineBasic(FoodHandle handle, const std::vector<std::string>& keywords, double calories);
+    void defineComposite(FoodHandle handle, const std::vector<std::string>& keywords);
+    void setKeywords(FoodHandle handle, const std::vector<std::string>& keywords);
+    void setCalories(FoodHandle handle, double calories);
+    void addComponent(FoodHandle composite, FoodHandle food, int servings);
+    void removeComponent(FoodHandle composite, FoodHandle food);
+    void clearComponents(FoodHandle composite);
+
+    friend class CatalogSnapshot;
+    friend class CatalogView;
+};
+
+// Non-owning, non-allocating calorie lookup for summary loops. Every row is
+// already resolved, so a lookup is a single array load. Interning new names
+// keeps the view valid; redefining foods or components does not.
+class CatalogView {
+private:
+    const FoodCatalog* catalog;
+
+public:
+    explicit CatalogView(const FoodCatalog& catalog) : catalog(&catalog) {}
+
+    double caloriesPerServing(FoodHandle handle) const { return catalog->calories[handle]; }
+    // The same values as one array indexed by handle, for batch kernels
+    const double* calorieTable() const { return catalog->calories.data(); }
+    bool isDefined(FoodHandle handle) const { return catalog->isDefined(handle); }
+    std::uint64_t revision() const { return catalog->calorieRevision; }
+};
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstddef>
+
+class Database;
+
+// Parallel loader for basic_foods.txt and composite_foods.txt. Each file is
+// mapped, cut into newline-aligned chunks and parsed on the shared thread
+// pool; the parsed chunks are merged into the catalog in file order, so
+// handles come out exactly as a sequential read would assign them.
+// Composite components are resolved in a second parallel pass once every
+// food is defined, so a composite may refer to one defined later in the file.
+class FoodFileLoader {
+public:
+    // Files smaller than this are parsed as a single chunk
+    static constexpr std::size_t MIN_CHUNK_BYTES = 64 * 1024;
+
+    // Fills the database before it publishes anything
+    static void load(Database& database);
+};
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Character trie over a keyword vocabulary, stored as flat first-child /
+// next-sibling arrays so it costs ten bytes a node and no allocation per
+// node. Children are kept in byte order, so every walk visits words sorted.
+// Removing a word only clears its end mark; callers rebuild once sparse().
+class KeywordTrie {
+private:
+    static constexpr std::uint32_t NONE = 0;  // the root is never a child
+
+    std::vector<std::uint32_t> firstChild;
+    std::vector<std::uint32_t> nextSibling;
+    std::vector<char> labels;
+    std::vector<std::uint8_t> wordEnds;
+    size_t wordCount;
+    size_t erasedCount;
+
+    std::uint32_t child(std::uint32_t node, char label) const;
+    std::uint32_t find(std::string_view word) const;
+
+    friend class CatalogSnapshot;
+
+public:
+    using Visitor = std::function<void(std::string_view word)>;
+
+    KeywordTrie();
+
+    void insert(std::string_view word);
+    void erase(std::string_view word);
+    void clear();
+    size_t size() const;
+    // True once erased words outnumber live ones enough to be worth a rebuild
+    bool sparse() const;
+
+    // Every word that starts with `prefix`
+    void forEachWithPrefix(std::string_view prefix, const Visitor& visit) const;
+    // Every word within `maxEdits` insertions, deletions or substitutions of
+    // `word`. The trie is walked with one edit-distance row per node, and a
+    // branch is dropped as soon as no cell in its row is within the bound.
+    void forEachWithin(std::string_view word, int maxEdits, const Visitor& visit) const;
+};
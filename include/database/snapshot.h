@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+class Database;
+
+// Versioned binary image of the food catalog, its keyword index and the
+// keyword vocabulary tries. The text files remain the interchange format; the
+// snapshot is only trusted when the text files still match the size and mtime
+// recorded in it and the payload checksum verifies.
+class CatalogSnapshot {
+public:
+    static constexpr std::uint32_t VERSION = 3;
+
+    // Replaces the contents of `database` from the snapshot if it is fresh
+    static bool load(const std::string& path, Database& database);
+    static bool write(const std::string& path, const Database& database);
+};
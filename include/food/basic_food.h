@@ -4,14 +4,15 @@
 
 class BasicFood : public Food {
 public:
-    BasicFood(const std::string& id, const std::vector<std::string>& keys, double calories);
+    BasicFood(Database& database, FoodHandle handle);
+
+    // Updates the calorie value and invalidates every composite built from this food
+    void setCaloriesPerServing(double calories);
 
     // Implementation of virtual methods
     double calculateCalories(int servings) const override;
     bool isComposite() const override;
     std::string toString() const override;
 
-    #ifdef DEBUG
-    void debugPrint() const override;
-    #endif
-}; 
\ No newline at end of file
+    void debugPrint(std::ostream& out) const override;
+}; 
@@ -1,30 +1,38 @@
 #pragma once
 
+#include <iosfwd>
 #include <string>
 #include <vector>
+#include "database/food_catalog.h"
 
+class Database;
+
+// Food objects are lightweight handles into the shared Database, which owns the
+// data and must outlive them. Getters read the currently published catalog and
+// return copies; setters go through the Database writers.
 class Food {
 protected:
-    std::string identifier;
-    std::vector<std::string> keywords;
-    double caloriesPerServing;
+    Database* database;
+    FoodHandle handle;
 
 public:
-    Food(const std::string& id, const std::vector<std::string>& keys, double calories);
+    Food(Database& database, FoodHandle handle);
     virtual ~Food() = default;
 
     // Getters
+    FoodHandle getHandle() const;
     std::string getIdentifier() const;
     std::vector<std::string> getKeywords() const;
     double getCaloriesPerServing() const;
 
+    // Setters
+    void setKeywords(const std::vector<std::string>& keys);
+
     // Virtual methods
     virtual double calculateCalories(int servings) const = 0;
     virtual bool isComposite() const = 0;
     virtual std::string toString() const = 0;
 
-    // Debug print
-    #ifdef DEBUG
-    virtual void debugPrint() const;
-    #endif
-}; 
\ No newline at end of file
+    // Debug dump, used by Database::debugPrint
+    virtual void debugPrint(std::ostream& out) const;
+}; 
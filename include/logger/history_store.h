@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstdint>
+#include <ctime>
+#include <list>
+#include <map>
+#include <string>
+#include <vector>
+#include "database/food_catalog.h"
+
+class Database;
+
+struct LogEntry {
+    FoodHandle food;
+    int servings;
+    std::time_t timestamp;
+};
+
+// One calendar year of one user's log in parallel columns. Rows are ordered
+// by day and, within a day, by log position; the rows of the d-th day of the
+// year are dayOffsets[d] .. dayOffsets[d + 1].
+struct HistorySegment {
+    int year = 0;
+    int firstDay = 0;
+    std::vector<std::uint32_t> dayOffsets;
+    std::vector<std::int32_t> days;
+    std::vector<FoodHandle> foods;
+    std::vector<std::int32_t> servings;
+    std::vector<std::int64_t> timestamps;
+
+    int dayCount() const;
+    size_t rowCount() const;
+};
+
+// Per-user log history stored as one <YYYY>.seg file per year. Each file
+// holds the columns of a HistorySegment plus a table of the food names it
+// uses, so handles survive catalog rebuilds. A few recently used years stay
+// cached; a whole year is rewritten when any of its days changes.
+class HistoryStore {
+private:
+    std::string directory;
+    Database& database;
+    std::map<int, HistorySegment> segments;
+    std::list<int> segmentOrder;  // most recently used year first
+
+    std::string segmentPath(int year) const;
+    HistorySegment& segment(int year);
+    bool readSegment(int year, HistorySegment& segment);
+    bool writeSegment(const HistorySegment& segment, const std::string& path) const;
+    // Shared by import and migration; false if the year files could not be
+    // written, in which case no source file was touched
+    bool copyDayFiles(const std::string& sourceDirectory, bool removeImported, size_t& copied);
+
+public:
+    static constexpr std::uint32_t VERSION = 1;
+    static constexpr size_t MAX_CACHED_SEGMENTS = 4;
+
+    struct Totals {
+        double calories;
+        int loggedDays;  // days in the range with at least one entry
+    };
+
+    HistoryStore(const std::string& directory, Database& database);
+
+    std::vector<LogEntry> readDay(int day);
+    bool hasDay(int day);
+    // Replaces each listed day (an empty list deletes it) and rewrites every
+    // affected year once. Returns false, changing nothing, if a file could
+    // not be written.
+    bool writeDays(const std::map<int, std::vector<LogEntry>>& days);
+    // Calories over [first, last] from the stored rows, one pass per year
+    Totals total(int first, int last);
+    // The same for each day of [first, last], in order
+    std::vector<Totals> dailyTotals(int first, int last);
+    void clearCache();
+
+    // Interchange with per-day <YYYY-MM-DD>.log text files; both return the
+    // number of days copied. Imported days replace the stored ones.
+    size_t importDayFiles(const std::string& sourceDirectory, bool removeImported);
+    size_t exportDayFiles(const std::string& targetDirectory);
+    // Moves day files left in this store's own directory by older versions
+    // into the year files; false if they could not be written and should be
+    // tried again later
+    bool migrateDayFiles();
+};
@@ -3,46 +3,179 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <set>
+#include <deque>
+#include <list>
 #include <memory>
 #include <ctime>
-#include "food/food.h"
+#include <cstdint>
+#include <mutex>
+#include "database/database.h"
+#include "logger/history_store.h"
 
-struct LogEntry {
-    std::string foodId;
-    int servings;
-    std::time_t timestamp;
+// One record of the per-user operation log
+struct LogOperation {
+    enum Type : char {
+        ADD = 'A',     // entry appended to the date
+        REMOVE = 'R',  // entry removed from `index`
+        UNDO = 'U'     // reverts an earlier ADD or REMOVE described by `undone`
+    };
+
+    std::uint64_t sequence;
+    Type type;
+    Type undone;
+    size_t index;
+    LogEntry entry;
+};
+
+// An undoable edit: the operation alone is enough to invert or replay it
+struct UndoRecord {
+    std::string date;
+    LogOperation operation;
+};
+
+enum class SummaryPeriod {
+    DAY,
+    WEEK,   // Monday to Sunday
+    MONTH,
+    YEAR
+};
+
+// Calorie totals for one period, clipped to the queried range
+struct CalorieSummary {
+    std::string startDate;
+    std::string endDate;
+    int days;
+    int loggedDays;
+    double totalCalories;
+
+    double averageCalories() const;  // per calendar day in the period
 };
 
+// One Logger per user. Every public method takes the logger's own mutex, so a
+// session may be driven from several threads; the lazily loaded caches are
+// mutable so const queries can fill them under that lock.
 class Logger {
 private:
-    std::map<std::string, std::vector<LogEntry>> dailyLogs;
+    mutable std::mutex mutex;
+
+    // Days parsed from disk, bounded by residentLimit bytes and evicted least
+    // recently used first. Evicting is always safe, even for an edited day:
+    // it is rebuilt from the stored history plus its pendingOperations.
+    struct ResidentDay {
+        std::vector<LogEntry> entries;
+        std::list<std::string>::iterator position;
+        size_t bytes;
+    };
+    mutable std::map<std::string, ResidentDay> residentDays;
+    mutable std::list<std::string> residentOrder;  // most recently used first
+    mutable size_t residentBytes;
+    size_t residentLimit;
+
     std::string logDirectory;
     std::string username;
-    std::vector<std::pair<std::string, std::vector<LogEntry>>> undoStack;
+    // Food IDs in stored logs are interned here; entries hold handles only
+    Database& database;
+    std::deque<UndoRecord> undoStack;
+    std::deque<UndoRecord> redoStack;
+    size_t undoLimit;
+    std::string historyFile;
+
+    // Append-only operation log. Every operation newer than the stored
+    // history stays in pendingOperations until compact() folds the dirty
+    // dates back into it. Dates are kept in canonical YYYY-MM-DD form, so
+    // the keys sort by day.
+    std::string operationsFile;
+    std::map<std::string, std::vector<LogOperation>> pendingOperations;
+    std::set<std::string> dirtyDates;
+    std::uint64_t nextSequence;
+    size_t operationCount;
+    // In batch mode operation records are held here until flush()
+    bool batchMode;
+    std::string heldOperations;
+
+    // Cached calorie rollups keyed by day number, Monday-week number and
+    // month number. Edits drop the affected day, week and month; any change
+    // to the food catalog drops everything.
+    struct Rollup {
+        double calories;
+        int loggedDays;
+    };
+    std::map<int, Rollup> dayRollups;
+    std::map<int, Rollup> weekRollups;
+    std::map<int, Rollup> monthRollups;
+    std::uint64_t rollupRevision;
 
-    void loadLog(const std::string& date);
-    void saveLog(const std::string& date) const;
-    std::string getLogFilePath(const std::string& date) const;
-    void pushUndoState(const std::string& date);
+    // Year segments under the user's directory; days without pending
+    // operations are read and totalled straight from here
+    mutable HistoryStore history;
+
+    std::vector<LogEntry> readLog(const std::string& date) const;
+    // Loads the day if needed and marks it most recently used. The reference
+    // stays valid until the next call, which may evict the day.
+    std::vector<LogEntry>& residentDay(const std::string& date) const;
+    void trimResident(const std::string* keep) const;
+    bool isLogged(const std::string& date) const;
+    bool hasPendingDays(int first, int last) const;
+    void pushUndoRecord(const std::string& date, const LogOperation& operation);
+    void readHistory();
+    void writeHistory() const;
+    void readOperations();
+    LogOperation appendOperation(const std::string& date, LogOperation operation);
+    static void applyOperation(std::vector<LogEntry>& entries, const LogOperation& operation);
+    void invalidateRollups(const std::string& date);
+    Rollup dayRollup(int day);
+    void fillDayRollups(int first, int last);
+    Rollup rangeRollup(int first, int last);
+    void flushLocked();
+    bool appendHeldOperations();
+    void compactLocked();
 
 public:
-    Logger(const std::string& logDirectory, const std::string& username);
+    static constexpr size_t COMPACT_OPERATIONS = 1000;
+    static constexpr size_t DEFAULT_UNDO_LIMIT = 100;
+    static constexpr size_t DEFAULT_RESIDENT_BYTES = 1 << 20;
+    // Left in the user directory once older per-day files have been migrated
+    static constexpr const char* MIGRATED_MARKER = "days.migrated";
+
+    Logger(const std::string& logDirectory, const std::string& username, Database& database);
 
     // Log operations
-    void addEntry(const std::string& date, const std::string& foodId, int servings);
-    void removeEntry(const std::string& date, size_t index);
+    void addEntry(const std::string& date, FoodHandle food, int servings);
+    // False if the day has no entry at `index`; checked under the same lock as the removal
+    bool removeEntry(const std::string& date, size_t index);
     std::vector<LogEntry> getLog(const std::string& date) const;
-    double calculateTotalCalories(const std::string& date, const std::map<std::string, std::shared_ptr<Food>>& foodDatabase) const;
+    double calculateTotalCalories(const std::string& date) const;
 
-    // Undo operations
+    // Range reports: one summary per period overlapping [from, to], in date order
+    std::vector<CalorieSummary> summarizeRange(const std::string& from, const std::string& to,
+                                               SummaryPeriod period);
+
+    // Undo operations; history is kept to the most recent `limit` edits
     void undo();
     bool canUndo() const;
+    void redo();
+    bool canRedo() const;
+    void setUndoLimit(size_t limit);
+    // Approximate memory budget for parsed days; evicts down to it at once
+    void setResidentLimit(size_t bytes);
 
     // File operations
-    void save() const;
+    void save();
+    // Drops every cached day and rereads the operation log and undo history;
+    // days are parsed again on first use
     void load();
+    // Folds every day touched by the operation log into the history and empties it
+    void compact();
+    // Batch mode holds operation-log writes in memory until flush()
+    void setBatchMode(bool enabled);
+    void flush();
+    // Interchange with per-day <YYYY-MM-DD>.log files (foodId|servings|timestamp
+    // lines); both return the number of days copied. Importing replaces the
+    // stored days it covers and clears the undo history.
+    size_t importDayFiles(const std::string& directory);
+    size_t exportDayFiles(const std::string& directory);
 
-    #ifdef DEBUG
+    // Dumps the contents at VERBOSE trace level
     void debugPrint() const;
-    #endif
-}; 
\ No newline at end of file
+};
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+// Wire format between `yada --client` and `yada --serve`. A request is one
+// CommandInterpreter line terminated by '\n'. The response is the command's
+// output followed by a status line; output lines that happen to start with
+// the status marker are escaped by doubling it.
+namespace protocol {
+    constexpr const char* DEFAULT_SOCKET_PATH = "data/yada.sock";
+    constexpr char MARKER = '%';
+    constexpr const char* STATUS_OK = "%ok";
+    constexpr const char* STATUS_FAILED = "%failed";
+    // Longest request line the server accepts
+    constexpr size_t MAX_REQUEST_BYTES = 64 * 1024;
+
+    // Frames `output` and appends the status line
+    std::string encodeResponse(const std::string& output, bool ok);
+    // Undoes the escaping of one response line; false if it is the status line
+    bool decodeLine(const std::string& line, std::string& text, bool& ok);
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+#include <iosfwd>
+#include <string>
+
+// Thin front end for `yada --serve`: sends each request line read from
+// `input` and prints the server's reply. Returns 0 if every request
+// succeeded, 1 if any failed and 2 if the server could not be reached.
+int runSessionClient(const std::string& socketPath, std::istream& input, std::ostream& output,
+                     bool interactive);
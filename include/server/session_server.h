@@ -0,0 +1,67 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "api/command_interpreter.h"
+#include "api/yada_service.h"
+
+// Long-running multi-user front end on a Unix domain socket. One acceptor
+// thread polls the listening socket and every idle connection; a connection
+// with input is handed to a fixed pool of workers, which run its complete
+// request lines through the connection's own CommandInterpreter and then
+// return it to the poll set. All connections share one YadaService, so the
+// food database is loaded once and each user's logs stay warm between logins.
+class SessionServer {
+private:
+    struct Connection {
+        int fd;
+        std::string input;
+        CommandInterpreter interpreter;
+        bool closing;
+
+        Connection(int fd, YadaService& service);
+    };
+
+    YadaService& service;
+    std::string socketPath;
+    size_t workerCount;
+    int listenFd;
+    // Written to by stop() and by workers handing a connection back
+    int wakePipe[2];
+    std::atomic<bool> stopping;
+
+    std::mutex queueMutex;
+    std::condition_variable queueReady;
+    std::deque<std::shared_ptr<Connection>> readyConnections;
+    std::vector<std::shared_ptr<Connection>> returnedConnections;
+    std::vector<std::thread> workers;
+
+    bool listen();
+    void wake();
+    void workerLoop();
+    void serve(Connection& connection);
+    void close(Connection& connection);
+
+public:
+    static constexpr size_t DEFAULT_WORKERS = 4;
+    // A reply that cannot be sent within this long drops the connection, so
+    // a client that stops reading cannot hold a worker
+    static constexpr int SEND_TIMEOUT_MS = 5000;
+
+    SessionServer(YadaService& service, const std::string& socketPath, size_t workers = DEFAULT_WORKERS);
+    ~SessionServer();
+    SessionServer(const SessionServer&) = delete;
+    SessionServer& operator=(const SessionServer&) = delete;
+
+    // Serves until stop(); returns a process exit status
+    int run();
+    // Async-signal-safe
+    void stop();
+};
@@ -59,7 +59,6 @@ public:
     std::string toString() const;
     void updateProfile(double height, int age, double weight, ActivityLevel level);
 
-    #ifdef DEBUG
+    // Dumps the contents at VERBOSE trace level
     void debugPrint() const;
-    #endif
 }; 
\ No newline at end of file
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace utils {
+    // FNV-1a, 64-bit; detects torn or foreign binary files
+    std::uint64_t checksum64(const char* data, std::size_t size);
+
+    // Writes `header` then `payload` to `path` and fsyncs it
+    bool writeFile(const std::string& path, const void* header, std::size_t headerSize, const std::string& payload);
+    // Appends `data` to `path`, creating it if needed, and fsyncs it
+    bool appendFile(const std::string& path, const std::string& data);
+    // Fsyncs the directory holding `path`, making a rename into it durable
+    bool syncDirectory(const std::string& path);
+    // Same as writeFile, through a temporary file renamed over `path` and a
+    // directory sync, so a crash leaves either the old file or the new one
+    bool replaceFile(const std::string& path, const void* header, std::size_t headerSize, const std::string& payload);
+
+    // Appends fixed-width values to a payload, padding every section to 8 bytes
+    class PayloadWriter {
+    private:
+        std::string bytes;
+
+    public:
+        template <typename T>
+        void put(const T& value) {
+            bytes.append(reinterpret_cast<const char*>(&value), sizeof(T));
+        }
+        template <typename T>
+        void putArray(const std::vector<T>& values) {
+            putBytes(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(T));
+        }
+        void putBytes(const char* data, std::size_t size) {
+            bytes.append(data, size);
+        }
+        void align() {
+            bytes.resize((bytes.size() + 7) & ~std::size_t(7), '\0');
+        }
+        const std::string& data() const { return bytes; }
+    };
+
+    // Walks a mapped payload section by section without copying it
+    class PayloadReader {
+    private:
+        const char* cursor;
+        const char* end;
+
+    public:
+        PayloadReader(const char* data, std::size_t size) : cursor(data), end(data + size) {}
+
+        const char* take(std::size_t size) {
+            if (static_cast<std::size_t>(end - cursor) < size) return nullptr;
+            const char* start = cursor;
+            cursor += size;
+            return start;
+        }
+        void align(const char* base) {
+            std::size_t offset = cursor - base;
+            cursor = base + ((offset + 7) & ~std::size_t(7));
+            if (cursor > end) cursor = end;
+        }
+    };
+
+    template <typename T>
+    bool copyArray(PayloadReader& reader, std::vector<T>& out, std::size_t count) {
+        const char* data = reader.take(count * sizeof(T));
+        if (!data) return false;
+        out.resize(count);
+        if (count) std::memcpy(out.data(), data, count * sizeof(T));
+        return true;
+    }
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace utils {
+    // Batch calorie reductions over log columns. `perServing` is a dense table
+    // indexed by food handle (CatalogView::calorieTable()); each row adds
+    // perServing[foods[i]] * servings[i]. Handles must be below 2^31.
+    struct CalorieKernel {
+        const char* name;
+        // Total over `count` rows
+        double (*sum)(const double* perServing, const std::uint32_t* foods, const std::int32_t* servings,
+                      std::size_t count);
+        // out[d] = total over rows offsets[d] .. offsets[d + 1], for each of `dayCount` days
+        void (*sumByDay)(const double* perServing, const std::uint32_t* foods, const std::int32_t* servings,
+                         const std::uint32_t* offsets, std::size_t dayCount, double* out);
+    };
+
+    // Widest implementation this CPU supports (AVX2 or NEON), chosen once at
+    // startup; the portable one is always available for comparison
+    const CalorieKernel& calorieKernel();
+    const CalorieKernel& scalarCalorieKernel();
+
+    inline double sumCalories(const double* perServing, const std::uint32_t* foods, const std::int32_t* servings,
+                              std::size_t count) {
+        return calorieKernel().sum(perServing, foods, servings, count);
+    }
+    inline void sumCaloriesByDay(const double* perServing, const std::uint32_t* foods, const std::int32_t* servings,
+                                 const std::uint32_t* offsets, std::size_t dayCount, double* out) {
+        calorieKernel().sumByDay(perServing, foods, servings, offsets, dayCount, out);
+    }
+}
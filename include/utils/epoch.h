@@ -0,0 +1,57 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace utils {
+    // Epoch-based read-side sections for RCU-style publication. Readers claim
+    // a slot with one CAS and record the epoch they started in; they never
+    // block each other or writers. A writer publishes new data, then calls
+    // synchronize() to wait until every section that could still see the old
+    // data has ended.
+    class EpochDomain {
+    public:
+        static constexpr std::size_t SLOTS = 128;
+
+        // RAII read-side section; move-only
+        class Section {
+        private:
+            const EpochDomain* domain;
+            std::size_t slot;
+
+        public:
+            Section(const EpochDomain* domain, std::size_t slot);
+            Section(Section&& other) noexcept;
+            Section(const Section&) = delete;
+            Section& operator=(const Section&) = delete;
+            Section& operator=(Section&&) = delete;
+            ~Section();
+        };
+
+        EpochDomain();
+        EpochDomain(const EpochDomain&) = delete;
+        EpochDomain& operator=(const EpochDomain&) = delete;
+
+        // Starts a read-side section (spins only if all SLOTS are in use)
+        Section enter() const;
+        // Waits for every section that began before this call to end. Must not
+        // be called from inside a section on the same thread.
+        void synchronize();
+
+        // True while the calling thread is inside a section of any domain
+        static bool inSection();
+
+    private:
+        static constexpr std::uint64_t IDLE = UINT64_MAX;
+
+        // One cache line per slot so readers on different cores do not contend
+        struct alignas(64) Slot {
+            std::atomic<std::uint64_t> epoch;
+        };
+
+        mutable std::array<Slot, SLOTS> slots;
+        std::atomic<std::uint64_t> epoch;
+    };
+}
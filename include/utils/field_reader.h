@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+namespace utils {
+    // Non-allocating tokenizer for the '|' and ',' separated data files. All
+    // returned views point into the text being read.
+    class FieldReader {
+    private:
+        std::string_view rest;
+
+    public:
+        explicit FieldReader(std::string_view text) : rest(text) {}
+
+        // Text up to the next `delimiter` (or the end), consuming the delimiter
+        std::string_view next(char delimiter);
+        // Everything not yet consumed
+        std::string_view remainder();
+        bool atEnd() const { return rest.empty(); }
+    };
+
+    // Splits `text` into lines; returns false once `text` is exhausted.
+    // A trailing '\r' is dropped from each line.
+    bool nextLine(std::string_view& text, std::string_view& line);
+
+    std::string_view trimView(std::string_view text);
+    // Whole-field numeric parses; surrounding whitespace is allowed
+    bool parseDouble(std::string_view text, double& value);
+    bool parseInt(std::string_view text, int& value);
+    bool parseInt(std::string_view text, std::int64_t& value);
+}
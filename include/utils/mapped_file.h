@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace utils {
+    // Read-only contents of a whole file: memory-mapped where the platform
+    // supports it, otherwise read into memory
+    class MappedFile {
+    private:
+        void* mapping;
+        std::size_t length;
+        std::string buffer;
+        bool opened;
+
+    public:
+        explicit MappedFile(const std::string& path);
+        ~MappedFile();
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        bool isOpen() const;
+        std::string_view contents() const;
+    };
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace utils {
+    // Bloom-signature filter over a dense table of 64-bit signatures indexed
+    // by food handle (FoodCatalog::signatureTable()). select() writes
+    // first + i for each i < count whose signature has every bit of `query`,
+    // in ascending order, and returns how many it wrote; `out` must have room
+    // for `count` handles. Survivors may still be false positives.
+    struct SignatureKernel {
+        const char* name;
+        std::size_t (*select)(const std::uint64_t* signatures, std::size_t count, std::uint64_t query,
+                              std::uint32_t first, std::uint32_t* out);
+    };
+
+    // Widest implementation this CPU supports (AVX2 or NEON), chosen once at
+    // startup; the portable one is always available for comparison
+    const SignatureKernel& signatureKernel();
+    const SignatureKernel& scalarSignatureKernel();
+
+    inline std::size_t selectSignatures(const std::uint64_t* signatures, std::size_t count, std::uint64_t query,
+                                        std::uint32_t first, std::uint32_t* out) {
+        return signatureKernel().select(signatures, count, query, first, out);
+    }
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstddef>
+
+namespace utils {
+    // Non-owning view over a contiguous run of elements (std::span is C++20)
+    template <typename T>
+    class Span {
+    private:
+        T* first;
+        std::size_t count;
+
+    public:
+        Span() : first(nullptr), count(0) {}
+        Span(T* first, std::size_t count) : first(first), count(count) {}
+
+        T* begin() const { return first; }
+        T* end() const { return first + count; }
+        std::size_t size() const { return count; }
+        bool empty() const { return count == 0; }
+        T& operator[](std::size_t i) const { return first[i]; }
+    };
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace utils {
+    // Fixed set of worker threads for fork-join work such as parallel file
+    // parsing. The calling thread takes part in every parallelFor, so nested
+    // calls from inside a task cannot deadlock.
+    class ThreadPool {
+    private:
+        std::vector<std::thread> workers;
+        std::deque<std::function<void()>> jobs;
+        std::mutex mutex;
+        std::condition_variable jobReady;
+        bool stopping;
+
+        void workerLoop();
+
+    public:
+        explicit ThreadPool(std::size_t threads);
+        ~ThreadPool();
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        // Worker threads plus the caller
+        std::size_t concurrency() const;
+
+        // Runs task(0) ... task(count - 1) and returns once all have finished.
+        // The first exception thrown by a task is rethrown here.
+        void parallelFor(std::size_t count, const std::function<void(std::size_t)>& task);
+
+        // Process-wide pool with one thread per additional hardware core
+        static ThreadPool& shared();
+    };
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <atomic>
+#include <sstream>
+#include <string>
+
+// Highest level compiled into the binary; statements above it vanish entirely.
+// 0 disables tracing, 5 keeps everything (set from CMake's YADA_TRACE_LEVEL).
+#ifndef YADA_TRACE_LEVEL
+#define YADA_TRACE_LEVEL 3
+#endif
+
+namespace trace {
+    enum class Level {
+        ERROR = 1,
+        WARNING = 2,
+        INFO = 3,
+        DETAIL = 4,
+        VERBOSE = 5
+    };
+
+    enum class Category : unsigned {
+        DATABASE = 1u << 0,
+        LOGGER = 1u << 1,
+        SEARCH = 1u << 2,
+        IO = 1u << 3,
+        APP = 1u << 4
+    };
+
+    namespace detail {
+        extern std::atomic<unsigned> categoryMask;
+        extern std::atomic<int> runtimeLevel;
+    }
+
+    // Runtime filter, seeded from YADA_TRACE ("database,search" or "all"),
+    // YADA_TRACE_LEVEL (1-5) and YADA_TRACE_FILE (default stderr). Without
+    // them every category traces warnings and errors.
+    inline bool enabled(Level level, Category category) {
+        return (detail::categoryMask.load(std::memory_order_relaxed) & static_cast<unsigned>(category)) != 0 &&
+               static_cast<int>(level) <= detail::runtimeLevel.load(std::memory_order_relaxed);
+    }
+
+    void configure(const std::string& categories, Level level);
+
+    // Messages are buffered and written in blocks; warnings and errors flush immediately
+    void write(Level level, Category category, const std::string& message);
+    void flush();
+}
+
+// True when a statement at this level/category would be emitted; use to guard
+// multi-line dumps. Constant-folds to false for levels that are compiled out.
+#define YADA_TRACE_ON(level, category)                                        \
+    (static_cast<int>(trace::Level::level) <= YADA_TRACE_LEVEL &&             \
+     trace::enabled(trace::Level::level, trace::Category::category))
+
+// YADA_TRACE(INFO, DATABASE, "Loaded " << count << " foods");
+// The message expression is only evaluated when the statement is enabled.
+#define YADA_TRACE(level, category, message)                                  \
+    do {                                                                      \
+        if (YADA_TRACE_ON(level, category)) {                                 \
+            std::ostringstream yada_trace_message_;                           \
+            yada_trace_message_ << message;                                   \
+            trace::write(trace::Level::level, trace::Category::category,      \
+                         yada_trace_message_.str());                          \
+        }                                                                     \
+    } while (0)
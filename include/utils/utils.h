@@ -15,6 +15,9 @@ namespace utils {
     std::string getCurrentDate();
     std::string formatDate(const std::time_t& timestamp);
     std::time_t parseDate(const std::string& date);
+    // Days since 1970-01-01 in the proleptic Gregorian calendar (no time zone involved)
+    int toDayNumber(const std::string& date);
+    std::string fromDayNumber(int day);
 
     // File operations
     bool createDirectory(const std::string& path);
@@ -23,16 +26,15 @@ namespace utils {
 
     // Input validation
     bool isValidDate(const std::string& date);
+    // Exactly YYYY-MM-DD, naming a day that exists
+    bool isCanonicalDate(const std::string& date);
     bool isValidNumber(const std::string& str);
     bool isValidUsername(const std::string& username);
     bool isValidPassword(const std::string& password);
+    // Free of the separators the data files and journals use (| , and line breaks)
+    bool isValidFoodField(const std::string& text);
 
     // Password hashing
     std::string hashPassword(const std::string& password);
     bool verifyPassword(const std::string& password, const std::string& hash);
-
-    // Debug printing
-    #ifdef DEBUG
-    void printDebug(const std::string& message);
-    #endif
 } 
\ No newline at end of file
@@ -0,0 +1,369 @@
+#include "api/command_interpreter.h"
+#include "utils/utils.h"
+#include <iomanip>
+#include <ostream>
+#include <sstream>
+
+namespace {
+
+// Whole-token numeric parse ("12abc" is rejected)
+template <typename T>
+bool parseNumber(const std::string& token, T& value) {
+    std::istringstream ss(token);
+    ss >> value;
+    return !ss.fail() && ss.eof();
+}
+
+bool parsePeriod(const std::string& token, SummaryPeriod& period) {
+    if (token == "day") period = SummaryPeriod::DAY;
+    else if (token == "week") period = SummaryPeriod::WEEK;
+    else if (token == "month") period = SummaryPeriod::MONTH;
+    else if (token == "year") period = SummaryPeriod::YEAR;
+    else return false;
+    return true;
+}
+
+bool parseMatch(const std::string& token, KeywordMatch& match) {
+    if (token == "exact") match = KeywordMatch::EXACT;
+    else if (token == "prefix") match = KeywordMatch::PREFIX;
+    else if (token == "fuzzy") match = KeywordMatch::FUZZY;
+    else return false;
+    return true;
+}
+
+bool parseGender(const std::string& token, Gender& gender) {
+    std::string lower = utils::toLower(token);
+    if (lower == "m" || lower == "male") gender = Gender::MALE;
+    else if (lower == "f" || lower == "female") gender = Gender::FEMALE;
+    else if (lower == "o" || lower == "other") gender = Gender::OTHER;
+    else return false;
+    return true;
+}
+
+} // namespace
+
+CommandInterpreter::CommandInterpreter(YadaService& service, bool holdWrites, bool fileAccess)
+    : service(service), currentDate(utils::getCurrentDate()), holdWrites(holdWrites), fileAccess(fileAccess) {}
+
+std::vector<std::string> CommandInterpreter::tokenize(const std::string& line) {
+    std::istringstream ss(line);
+    std::vector<std::string> args;
+    std::string arg;
+    while (ss >> std::quoted(arg)) {
+        args.push_back(arg);
+    }
+    if (!args.empty() && args[0][0] == '#') args.clear();
+    return args;
+}
+
+const char* CommandInterpreter::help() {
+    return "register <username> <password> <m|f|o> <height> <age> <weight> <activity 1-5>\n"
+           "login <username> <password>\n"
+           "logout\n"
+           "add-food <id> <calories> <keywords>\n"
+           "add-composite <id> <keywords> [<component> <servings>]...\n"
+           "search <all|any> <keywords> [exact|prefix|fuzzy]\n"
+           "top <all|any> <keywords> <count> [exact|prefix|fuzzy]\n"
+           "more\n"
+           "log <food> <servings> [date]\n"
+           "view [date]\n"
+           "delete <entry number> [date]\n"
+           "undo\n"
+           "redo\n"
+           "profile [<height> <age> <weight> <activity 1-5>]\n"
+           "summary [date]\n"
+           "report <from> <to> <day|week|month|year>\n"
+           "import-logs <directory>\n"
+           "export-logs <directory>\n"
+           "commit\n";
+}
+
+bool CommandInterpreter::requireUser(std::ostream& out) const {
+    if (!session) {
+        out << "Not logged in.\n";
+        return false;
+    }
+    return true;
+}
+
+void CommandInterpreter::commit() {
+    service.commit();
+    if (session) session->flush();
+}
+
+void CommandInterpreter::logout() {
+    if (!session) return;
+    if (holdWrites) session->setBatchMode(false);
+    // Fold this session's operation log into the history
+    session->save();
+    session = nullptr;
+}
+
+void CommandInterpreter::printLog(const std::string& date, std::ostream& out) const {
+    auto log = session->getLog(date);
+    if (log.value.empty()) {
+        out << "No entries found for " << date << "\n";
+        return;
+    }
+    out << "Log for " << date << ":\n";
+    for (const auto& item : log.value) {
+        if (item.defined) {
+            out << item.index + 1 << ". " << item.foodId
+                << " (" << item.servings << " servings) - "
+                << item.calories << " calories\n";
+        }
+    }
+}
+
+void CommandInterpreter::printRankedPage(std::ostream& out) {
+    RankedQuery& query = rankedQuery;
+    auto page = service.searchFoodsRanked(query.keywords, query.matchAll, query.limit, query.next, query.match);
+    query.next = page.next;
+    query.more = page.more;
+    out << page.foods.size() << " match(es):";
+    for (const auto& food : page.foods) {
+        out << " " << food.id;
+    }
+    out << (page.more ? "\nMore matches follow; enter \"more\" to see them.\n" : "\n");
+}
+
+void CommandInterpreter::printReport(const std::string& from, const std::string& to,
+                                     SummaryPeriod period, std::ostream& out) {
+    auto report = session->report(from, to, period);
+    for (const auto& summary : report.value.periods) {
+        out << summary.startDate;
+        if (summary.endDate != summary.startDate) {
+            out << " to " << summary.endDate;
+        }
+        out << ": " << summary.totalCalories << " calories, "
+            << summary.averageCalories() << " per day ("
+            << summary.loggedDays << "/" << summary.days << " days logged)\n";
+    }
+    out << "Total: " << report.value.totalCalories << " calories\n"
+        << "Average per day: " << report.value.averageCalories() << " calories\n"
+        << "Target per day: " << report.value.targetCalories << " calories\n";
+}
+
+bool CommandInterpreter::execute(const std::vector<std::string>& args, std::ostream& out) {
+    const std::string& command = args[0];
+    auto report = [&out](const Status& status) {
+        if (!status.ok) out << status.error << "\n";
+        return status.ok;
+    };
+
+    // register <username> <password> <m|f|o> <height> <age> <weight> <activity 1-5>
+    if (command == "register" && args.size() == 8) {
+        Gender gender;
+        double height, weight;
+        int age, activity;
+        if (!parseGender(args[3], gender) || !parseNumber(args[4], height) || !parseNumber(args[5], age)
+            || !parseNumber(args[6], weight) || !parseNumber(args[7], activity) || activity < 1 || activity > 5) {
+            out << "Invalid profile.\n";
+            return false;
+        }
+        if (!report(service.registerUser(args[1], args[2], gender, height, age, weight,
+                                         static_cast<ActivityLevel>(activity - 1)))) {
+            return false;
+        }
+        out << "Registration successful!\n";
+        return true;
+    }
+
+    if (command == "login" && args.size() == 3) {
+        auto result = service.login(args[1], args[2]);
+        if (!result.ok) return report(Status::failure(result.error));
+        logout();
+        session = result.value;
+        if (holdWrites) session->setBatchMode(true);
+        out << "Login successful!\n";
+        return true;
+    }
+
+    if (command == "logout" && args.size() == 1) {
+        if (!requireUser(out)) return false;
+        logout();
+        out << "Logged out.\n";
+        return true;
+    }
+
+    // The food database is shared by every session, so changing it needs a login
+    if (command == "add-food" && args.size() == 4) {
+        if (!requireUser(out)) return false;
+        double calories;
+        if (!parseNumber(args[2], calories)) {
+            out << "Invalid calories: " << args[2] << "\n";
+            return false;
+        }
+        return report(service.addBasicFood(args[1], utils::splitString(args[3], ','), calories));
+    }
+
+    // add-composite <id> <keywords> [<component> <servings>]...
+    if (command == "add-composite" && args.size() >= 3 && args.size() % 2 == 1) {
+        if (!requireUser(out)) return false;
+        std::vector<FoodComponentInfo> components;
+        for (size_t i = 3; i < args.size(); i += 2) {
+            int servings;
+            if (!parseNumber(args[i + 1], servings)) {
+                out << "Invalid servings: " << args[i + 1] << "\n";
+                return false;
+            }
+            components.push_back({args[i], servings});
+        }
+        return report(service.addCompositeFood(args[1], utils::splitString(args[2], ','), components));
+    }
+
+    // search <all|any> <keywords> [exact|prefix|fuzzy]
+    if (command == "search" && (args.size() == 3 || args.size() == 4) && (args[1] == "all" || args[1] == "any")) {
+        KeywordMatch match = KeywordMatch::EXACT;
+        if (args.size() == 4 && !parseMatch(args[3], match)) {
+            out << "Invalid match mode: " << args[3] << "\n";
+            return false;
+        }
+        auto results = service.searchFoods(utils::splitString(args[2], ','), args[1] == "all", match);
+        out << results.size() << " match(es):";
+        for (const auto& food : results) {
+            out << " " << food.id;
+        }
+        out << "\n";
+        return true;
+    }
+
+    // top <all|any> <keywords> <count> [exact|prefix|fuzzy]
+    if (command == "top" && (args.size() == 4 || args.size() == 5) && (args[1] == "all" || args[1] == "any")) {
+        RankedQuery query;
+        int count;
+        if (!parseNumber(args[3], count) || count < 1) {
+            out << "Invalid count: " << args[3] << "\n";
+            return false;
+        }
+        query.limit = static_cast<size_t>(count);
+        if (args.size() == 5 && !parseMatch(args[4], query.match)) {
+            out << "Invalid match mode: " << args[4] << "\n";
+            return false;
+        }
+        query.keywords = utils::splitString(args[2], ',');
+        query.matchAll = args[1] == "all";
+        rankedQuery = query;
+        printRankedPage(out);
+        return true;
+    }
+
+    if (command == "more" && args.size() == 1) {
+        if (!rankedQuery.more) {
+            out << "No more matches.\n";
+            return false;
+        }
+        printRankedPage(out);
+        return true;
+    }
+
+    // log <food> <servings> [date]
+    if (command == "log" && (args.size() == 3 || args.size() == 4)) {
+        if (!requireUser(out)) return false;
+        int servings;
+        if (!parseNumber(args[2], servings)) {
+            out << "Invalid servings: " << args[2] << "\n";
+            return false;
+        }
+        return report(session->addEntry(args.size() == 4 ? args[3] : currentDate, args[1], servings));
+    }
+
+    // view [date]
+    if (command == "view" && args.size() <= 2) {
+        if (!requireUser(out)) return false;
+        std::string date = args.size() == 2 ? args[1] : currentDate;
+        if (!utils::isValidDate(date)) return report(Status::failure("Invalid date format."));
+        printLog(date, out);
+        return true;
+    }
+
+    // delete <entry number> [date]
+    if (command == "delete" && (args.size() == 2 || args.size() == 3)) {
+        if (!requireUser(out)) return false;
+        int index;
+        if (!parseNumber(args[1], index) || index < 1) {
+            out << "Invalid entry number.\n";
+            return false;
+        }
+        return report(session->removeEntry(args.size() == 3 ? args[2] : currentDate, index - 1));
+    }
+
+    if (command == "undo" && args.size() == 1) {
+        return requireUser(out) && report(session->undo());
+    }
+
+    if (command == "redo" && args.size() == 1) {
+        return requireUser(out) && report(session->redo());
+    }
+
+    // profile [<height> <age> <weight> <activity 1-5>]
+    if (command == "profile" && (args.size() == 1 || args.size() == 5)) {
+        if (!requireUser(out)) return false;
+        if (args.size() == 1) {
+            out << session->getUser()->toString() << "\n";
+            return true;
+        }
+        double height, weight;
+        int age, activity;
+        if (!parseNumber(args[1], height) || !parseNumber(args[2], age) || !parseNumber(args[3], weight)
+            || !parseNumber(args[4], activity) || activity < 1 || activity > 5) {
+            out << "Invalid profile.\n";
+            return false;
+        }
+        return report(service.updateProfile(session->getUser()->getUsername(), height, age, weight,
+                                            static_cast<ActivityLevel>(activity - 1)));
+    }
+
+    // summary [date]
+    if (command == "summary" && args.size() <= 2) {
+        if (!requireUser(out)) return false;
+        auto summary = session->summarize(args.size() == 2 ? args[1] : currentDate);
+        if (!summary.ok) return report(Status::failure(summary.error));
+        out << summary.value.date << ": consumed " << summary.value.consumedCalories
+            << ", target " << summary.value.targetCalories << "\n";
+        return true;
+    }
+
+    // report <from> <to> <day|week|month|year>
+    if (command == "report" && args.size() == 4) {
+        if (!requireUser(out)) return false;
+        SummaryPeriod period;
+        if (!parsePeriod(args[3], period)) {
+            out << "Invalid period: " << args[3] << "\n";
+            return false;
+        }
+        if (!utils::isValidDate(args[1]) || !utils::isValidDate(args[2]) || args[1] > args[2]) {
+            return report(Status::failure("Invalid date range."));
+        }
+        printReport(args[1], args[2], period, out);
+        return true;
+    }
+
+    // import-logs <directory>, export-logs <directory>
+    if ((command == "import-logs" || command == "export-logs") && args.size() == 2) {
+        if (!fileAccess) {
+            out << "Not available over a server connection.\n";
+            return false;
+        }
+        if (!requireUser(out)) return false;
+        bool importing = command == "import-logs";
+        auto copied = importing ? session->importLogs(args[1]) : session->exportLogs(args[1]);
+        if (!copied.ok) return report(Status::failure(copied.error));
+        out << (importing ? "Imported " : "Exported ") << copied.value << " day(s).\n";
+        return true;
+    }
+
+    if (command == "commit" && args.size() == 1) {
+        if (!requireUser(out)) return false;
+        commit();
+        return true;
+    }
+
+    if (command == "help" && args.size() == 1) {
+        out << help();
+        return true;
+    }
+
+    out << "Unknown command or wrong arguments: " << command << "\n";
+    return false;
+}
@@ -0,0 +1,124 @@
+#include "api/user_session.h"
+#include "utils/utils.h"
+#include <filesystem>
+
+UserSession::UserSession(std::shared_ptr<const User> user, Database& database, const std::string& logDirectory)
+    : user(std::move(user)), database(database),
+      logger(logDirectory, this->user->getUsername(), database) {}
+
+std::shared_ptr<const User> UserSession::getUser() const {
+    return std::atomic_load(&user);
+}
+
+void UserSession::setUser(std::shared_ptr<const User> updated) {
+    std::atomic_store(&user, std::move(updated));
+}
+
+Status UserSession::addEntry(const std::string& date, const std::string& foodId, int servings) {
+    if (!utils::isValidDate(date)) {
+        return Status::failure("Invalid date format.");
+    }
+    FoodHandle food = database.findFood(foodId);
+    if (food == INVALID_FOOD_HANDLE) {
+        return Status::failure("Food not found.");
+    }
+    logger.addEntry(date, food, servings);
+    return Status::success();
+}
+
+Status UserSession::removeEntry(const std::string& date, size_t index) {
+    if (!utils::isValidDate(date)) {
+        return Status::failure("Invalid date format.");
+    }
+    // Another client of a shared session may remove entries concurrently, so
+    // the logger checks the index itself
+    if (!logger.removeEntry(date, index)) {
+        return Status::failure("Invalid entry number.");
+    }
+    return Status::success();
+}
+
+Status UserSession::undo() {
+    if (!logger.canUndo()) {
+        return Status::failure("Nothing to undo.");
+    }
+    logger.undo();
+    return Status::success();
+}
+
+Status UserSession::redo() {
+    if (!logger.canRedo()) {
+        return Status::failure("Nothing to redo.");
+    }
+    logger.redo();
+    return Status::success();
+}
+
+Result<std::vector<LogItem>> UserSession::getLog(const std::string& date) const {
+    if (!utils::isValidDate(date)) {
+        return Result<std::vector<LogItem>>::failure("Invalid date format.");
+    }
+    auto entries = logger.getLog(date);
+    auto reader = database.read();
+    const auto& catalog = reader.catalog();
+    std::vector<LogItem> items;
+    items.reserve(entries.size());
+    for (size_t i = 0; i < entries.size(); ++i) {
+        const auto& entry = entries[i];
+        bool defined = catalog.isDefined(entry.food);
+        items.push_back({i, defined, defined ? std::string(catalog.name(entry.food)) : std::string(),
+                         entry.servings, defined ? catalog.caloriesPerServing(entry.food) * entry.servings : 0.0,
+                         entry.timestamp});
+    }
+    return Result<std::vector<LogItem>>::success(std::move(items));
+}
+
+Result<DailySummary> UserSession::summarize(const std::string& date) const {
+    if (!utils::isValidDate(date)) {
+        return Result<DailySummary>::failure("Invalid date format.");
+    }
+    double consumed = logger.calculateTotalCalories(date);
+    return Result<DailySummary>::success({date, consumed, getUser()->calculateTargetCalories()});
+}
+
+Result<RangeReport> UserSession::report(const std::string& from, const std::string& to, SummaryPeriod period) {
+    if (!utils::isValidDate(from) || !utils::isValidDate(to) || from > to) {
+        return Result<RangeReport>::failure("Invalid date range.");
+    }
+    RangeReport report;
+    report.periods = logger.summarizeRange(from, to, period);
+    report.totalCalories = 0.0;
+    report.days = 0;
+    for (const auto& summary : report.periods) {
+        report.totalCalories += summary.totalCalories;
+        report.days += summary.days;
+    }
+    report.targetCalories = getUser()->calculateTargetCalories();
+    return Result<RangeReport>::success(std::move(report));
+}
+
+void UserSession::setBatchMode(bool enabled) {
+    logger.setBatchMode(enabled);
+}
+
+void UserSession::flush() {
+    logger.flush();
+}
+
+void UserSession::save() {
+    logger.save();
+}
+
+Result<size_t> UserSession::importLogs(const std::string& directory) {
+    if (!std::filesystem::is_directory(directory)) {
+        return Result<size_t>::failure("No such directory: " + directory);
+    }
+    return Result<size_t>::success(logger.importDayFiles(directory));
+}
+
+Result<size_t> UserSession::exportLogs(const std::string& directory) {
+    if (directory.empty()) {
+        return Result<size_t>::failure("No directory given.");
+    }
+    return Result<size_t>::success(logger.exportDayFiles(directory));
+}
@@ -0,0 +1,281 @@
+#include "api/yada_service.h"
+#include "utils/utils.h"
+#include "utils/trace.h"
+#include <fstream>
+#include <sstream>
+
+namespace {
+
+// Ids and keywords are stored between separators, so one containing them would
+// not read back
+Status checkFoodFields(const std::string& id, const std::vector<std::string>& keywords) {
+    if (id.empty()) {
+        return Status::failure("Food identifier is empty.");
+    }
+    if (!utils::isValidFoodField(id)) {
+        return Status::failure("Food identifier may not contain '|', ',' or line breaks.");
+    }
+    for (const auto& keyword : keywords) {
+        if (!utils::isValidFoodField(keyword)) {
+            return Status::failure("Keyword may not contain '|', ',' or line breaks: " + keyword);
+        }
+    }
+    return Status::success();
+}
+
+} // namespace
+
+YadaService::YadaService(const std::string& dataDirectory)
+    : dataDirectory(dataDirectory),
+      usersFile(dataDirectory + "/users.txt"),
+      logDirectory(dataDirectory + "/daily_logs"),
+      sessionCacheSize(DEFAULT_SESSION_CACHE),
+      batchMode(false) {
+    utils::createDirectory(dataDirectory);
+    utils::createDirectory(logDirectory);
+
+    database = std::make_unique<Database>(dataDirectory + "/basic_foods.txt",
+                                          dataDirectory + "/composite_foods.txt");
+    loadUsers();
+    YADA_TRACE(VERBOSE, APP, "Created YadaService over " << dataDirectory);
+}
+
+YadaService::~YadaService() {
+    for (const auto& session : warmSessions) {
+        session->save();
+    }
+}
+
+void YadaService::loadUsers() {
+    std::ifstream file(usersFile);
+    if (!file.is_open()) {
+        YADA_TRACE(DETAIL, APP, "No users file found, starting fresh");
+        return;
+    }
+
+    std::string line;
+    while (std::getline(file, line)) {
+        std::stringstream ss(line);
+        std::string username, passwordHash, genderStr;
+        double height;
+        int age;
+        double weight;
+        int activityLevel;
+
+        std::getline(ss, username, '|');
+        std::getline(ss, passwordHash, '|');
+        std::getline(ss, genderStr, '|');
+        ss >> height >> age >> weight >> activityLevel;
+
+        Gender gender = (genderStr == "MALE") ? Gender::MALE :
+                       (genderStr == "FEMALE") ? Gender::FEMALE : Gender::OTHER;
+
+        users[username] = std::make_shared<User>(username, passwordHash, gender,
+                                                height, age, weight,
+                                                static_cast<ActivityLevel>(activityLevel));
+    }
+    YADA_TRACE(INFO, APP, "Loaded " << users.size() << " users");
+}
+
+void YadaService::saveUsers() const {
+    std::ofstream file(usersFile);
+    if (!file.is_open()) {
+        YADA_TRACE(WARNING, IO, "Could not open users file for writing");
+        return;
+    }
+
+    for (const auto& [username, user] : users) {
+        file << username << "|" << user->getPasswordHash() << "|"
+             << (user->getGender() == Gender::MALE ? "MALE" :
+                 user->getGender() == Gender::FEMALE ? "FEMALE" : "OTHER") << "|"
+             << user->getHeight() << " " << user->getAge() << " "
+             << user->getWeight() << " " << static_cast<int>(user->getActivityLevel()) << "\n";
+    }
+    YADA_TRACE(INFO, APP, "Saved " << users.size() << " users");
+}
+
+Result<std::shared_ptr<UserSession>> YadaService::login(const std::string& username, const std::string& password) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = users.find(username);
+    if (it == users.end() || !utils::verifyPassword(password, it->second->getPasswordHash())) {
+        return Result<std::shared_ptr<UserSession>>::failure("Invalid username or password.");
+    }
+
+    // Every live session of a user is the same object, so they share one Logger
+    for (auto warm = warmSessions.begin(); warm != warmSessions.end(); ++warm) {
+        if ((*warm)->getUser()->getUsername() == username) {
+            warmSessions.splice(warmSessions.begin(), warmSessions, warm);
+            YADA_TRACE(DETAIL, APP, "Reusing warm session for " << username);
+            return Result<std::shared_ptr<UserSession>>::success(warmSessions.front());
+        }
+    }
+    warmSessions.push_front(std::make_shared<UserSession>(it->second, *database, logDirectory));
+    auto session = warmSessions.front();
+    trimSessions();
+    return Result<std::shared_ptr<UserSession>>::success(session);
+}
+
+void YadaService::trimSessions() {
+    // Only the cache holds an idle session; busy ones stay until released
+    auto it = warmSessions.end();
+    while (warmSessions.size() > sessionCacheSize && it != warmSessions.begin()) {
+        --it;
+        if (it->use_count() == 1) {
+            (*it)->save();
+            YADA_TRACE(DETAIL, APP, "Evicted session for " << (*it)->getUser()->getUsername());
+            it = warmSessions.erase(it);
+        }
+    }
+}
+
+void YadaService::setSessionCacheSize(size_t size) {
+    std::lock_guard<std::mutex> lock(mutex);
+    sessionCacheSize = size;
+    trimSessions();
+}
+
+Status YadaService::registerUser(const std::string& username, const std::string& password,
+                                 Gender gender, double height, int age, double weight,
+                                 ActivityLevel activityLevel) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (users.find(username) != users.end()) {
+        return Status::failure("Username already exists.");
+    }
+    if (!utils::isValidUsername(username)) {
+        return Status::failure("Invalid username format.");
+    }
+    if (!utils::isValidPassword(password)) {
+        return Status::failure("Invalid password format.");
+    }
+
+    std::string passwordHash = utils::hashPassword(password);
+    users[username] = std::make_shared<User>(username, passwordHash, gender,
+                                            height, age, weight, activityLevel);
+    saveUsers();
+    return Status::success();
+}
+
+Status YadaService::updateProfile(const std::string& username, double height, int age, double weight,
+                                  ActivityLevel activityLevel) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = users.find(username);
+    if (it == users.end()) {
+        return Status::failure("User not found.");
+    }
+    // Users are immutable once shared; publish an updated copy instead
+    auto updated = std::make_shared<User>(*it->second);
+    updated->updateProfile(height, age, weight, activityLevel);
+    it->second = updated;
+    for (const auto& session : warmSessions) {
+        if (session->getUser()->getUsername() == username) session->setUser(updated);
+    }
+    saveUsers();
+    return Status::success();
+}
+
+bool YadaService::userExists(const std::string& username) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return users.find(username) != users.end();
+}
+
+Status YadaService::addBasicFood(const std::string& id, const std::vector<std::string>& keywords, double calories) {
+    Status valid = checkFoodFields(id, keywords);
+    if (!valid.ok) return valid;
+    database->addBasicFood(id, keywords, calories);
+    if (!batchMode) database->save();
+    return Status::success();
+}
+
+Status YadaService::addCompositeFood(const std::string& id, const std::vector<std::string>& keywords,
+                                     const std::vector<FoodComponentInfo>& components) {
+    Status valid = checkFoodFields(id, keywords);
+    if (!valid.ok) return valid;
+    std::vector<std::pair<FoodHandle, int>> resolved;
+    FoodHandle existing = database->findFood(id);
+    for (const auto& component : components) {
+        FoodHandle food = database->findFood(component.foodId);
+        if (food == INVALID_FOOD_HANDLE || component.foodId == id) {
+            return Status::failure("Food not found: " + component.foodId);
+        }
+        // Redefining a food must not make it a component of itself
+        if (existing != INVALID_FOOD_HANDLE && database->read().catalog().contains(food, existing)) {
+            return Status::failure(component.foodId + " already contains " + id + ".");
+        }
+        resolved.emplace_back(food, component.servings);
+    }
+
+    database->addCompositeFood(id, keywords);
+    FoodHandle composite = database->findFood(id);
+    for (const auto& [food, servings] : resolved) {
+        // Another session may have redefined the food since the checks above
+        if (!database->addComponent(composite, food, servings)) {
+            if (!batchMode) database->save();
+            return Status::failure("Could not add " + std::string(database->read().catalog().name(food))
+                                   + " to " + id + "; it changed while the food was being defined.");
+        }
+    }
+    if (!batchMode) database->save();
+    return Status::success();
+}
+
+bool YadaService::foodExists(const std::string& id) const {
+    return database->findFood(id) != INVALID_FOOD_HANDLE;
+}
+
+FoodInfo YadaService::describeFood(FoodHandle food) const {
+    auto reader = database->read();
+    const auto& catalog = reader.catalog();
+    FoodInfo info;
+    info.id = std::string(catalog.name(food));
+    info.composite = catalog.kind(food) == FoodKind::COMPOSITE;
+    for (KeywordId keyword : catalog.keywords(food)) {
+        info.keywords.emplace_back(catalog.keywordText(keyword));
+    }
+    info.caloriesPerServing = catalog.caloriesPerServing(food);
+    for (const auto& component : catalog.components(food)) {
+        info.components.push_back({std::string(catalog.name(component.food)), component.servings});
+    }
+    return info;
+}
+
+Result<FoodInfo> YadaService::getFood(const std::string& id) const {
+    FoodHandle food = database->findFood(id);
+    if (food == INVALID_FOOD_HANDLE) {
+        return Result<FoodInfo>::failure("Food not found.");
+    }
+    return Result<FoodInfo>::success(describeFood(food));
+}
+
+std::vector<FoodInfo> YadaService::searchFoods(const std::vector<std::string>& keywords, bool matchAll,
+                                               KeywordMatch match) const {
+    std::vector<FoodInfo> results;
+    for (FoodHandle food : database->matchFoods(keywords, matchAll, match)) {
+        results.push_back(describeFood(food));
+    }
+    return results;
+}
+
+FoodPage YadaService::searchFoodsRanked(const std::vector<std::string>& keywords, bool matchAll, size_t limit,
+                                        const SearchCursor& after, KeywordMatch match) const {
+    RankedPage ranked = database->searchRanked(keywords, matchAll, limit, after, match);
+    FoodPage page;
+    for (const auto& hit : ranked.foods) {
+        page.foods.push_back(describeFood(hit.handle));
+    }
+    page.next = ranked.next;
+    page.more = ranked.more;
+    return page;
+}
+
+void YadaService::setBatchMode(bool enabled) {
+    batchMode = enabled;
+    if (!batchMode) commit();
+}
+
+void YadaService::commit() {
+    database->save();
+}
+
+Database& YadaService::getDatabase() {
+    return *database;
+}
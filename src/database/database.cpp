@@ -1,378 +1,1111 @@
 #include "database/database.h"
+#include "database/snapshot.h"
+#include "database/food_file_loader.h"
 #include "utils/utils.h"
+#include "utils/binary_io.h"
+#include "utils/field_reader.h"
+#include "utils/trace.h"
+#include "utils/signature_kernel.h"
+#include <filesystem>
 #include <fstream>
 #include <sstream>
-#include <iostream>
+#include <stdexcept>
 #include <algorithm>
+#include <cmath>
+#include <iterator>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
-Database::Database(const std::string& basicFoodsFile, const std::string& compositeFoodsFile)
-    : basicFoodsFile(basicFoodsFile), compositeFoodsFile(compositeFoodsFile) {
-    loadBasicFoods();
-    loadCompositeFoods();
-    #ifdef DEBUG
-    std::cout << "DEBUG: Created Database object" << std::endl;
-    #endif
-}
-
-void Database::loadBasicFoods() {
-    std::ifstream file(basicFoodsFile);
-    if (!file.is_open()) {
-        #ifdef DEBUG
-        std::cout << "DEBUG: Could not open basic foods file: " << basicFoodsFile << std::endl;
-        #endif
-        return;
+namespace {
+
+std::string joinKeywords(const std::vector<std::string>& keywords) {
+    std::string joined;
+    for (size_t i = 0; i < keywords.size(); ++i) {
+        joined += keywords[i];
+        if (i < keywords.size() - 1) joined += ",";
     }
+    return joined;
+}
 
-    std::string line;
-    while (std::getline(file, line)) {
-        if (line.empty()) continue;
-        
-        std::stringstream ss(line);
-        std::string id, keywordStr;
-        double calories;
-        std::vector<std::string> keywords;
-
-        // Read ID and calories
-        std::getline(ss, id, '|');
-        ss >> calories;
-        ss.ignore(); // Skip the separator
-
-        // Read keywords
-        std::getline(ss, keywordStr);
-        keywords = utils::splitString(keywordStr, ',');
-
-        #ifdef DEBUG
-        std::cout << "DEBUG: Loading basic food - ID: " << id 
-                  << ", Calories: " << calories 
-                  << ", Keywords: ";
-        for (const auto& kw : keywords) {
-            std::cout << kw << " ";
-        }
-        std::cout << std::endl;
-        #endif
+// Orders ranked hits best first: higher score, then lower handle
+bool ranksBefore(const RankedFood& a, const RankedFood& b) {
+    return a.score != b.score ? a.score > b.score : a.handle < b.handle;
+}
+
+// IDF of a keyword found in `matches` of `foods` foods, in thousandths
+std::uint64_t keywordWeight(size_t matches, size_t foods) {
+    double rarity = (static_cast<double>(foods) - matches + 0.5) / (matches + 0.5);
+    return std::max<std::uint64_t>(1, std::llround(1000.0 * std::log1p(std::max(rarity, 0.0))));
+}
 
-        basicFoods[id] = std::make_shared<BasicFood>(id, keywords, calories);
+// Index of the lowest set bit of a non-zero word
+int lowestBit(std::uint64_t word) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctzll(word);
+#else
+    int bit = 0;
+    for (; (word & 1) == 0; word >>= 1) ++bit;
+    return bit;
+#endif
+}
+
+// First handle >= target in [from, end). Gallops, so a long skip costs the
+// logarithm of its length.
+const FoodHandle* seekHandle(const FoodHandle* from, const FoodHandle* end, FoodHandle target) {
+    // Most seeks in a leapfrog land close by, where a short scan wins
+    for (int probe = 0; probe < 8; ++probe, ++from) {
+        if (from == end || *from >= target) return from;
+    }
+    const FoodHandle* low = from;
+    size_t step = 1;
+    while (static_cast<size_t>(end - low) > step && low[step] < target) {
+        low += step + 1;
+        step *= 2;
     }
-    #ifdef DEBUG
-    std::cout << "DEBUG: Loaded " << basicFoods.size() << " basic foods" << std::endl;
-    #endif
+    return std::lower_bound(low, low + std::min<size_t>(step + 1, end - low), target);
 }
 
-void Database::loadCompositeFoods() {
-    std::ifstream file(compositeFoodsFile);
-    if (!file.is_open()) {
-        #ifdef DEBUG
-        std::cout << "DEBUG: Could not open composite foods file: " << compositeFoodsFile << std::endl;
-        #endif
-        return;
+// Whether the food has every keyword in `wanted`; both are ascending
+bool hasKeywords(const FoodCatalog& catalog, FoodHandle handle, const std::vector<KeywordId>& wanted) {
+    auto keywords = catalog.keywords(handle);
+    return std::includes(keywords.begin(), keywords.end(), wanted.begin(), wanted.end());
+}
+
+size_t seekPosting(const std::vector<FoodHandle>& postings, size_t from, FoodHandle target) {
+    const FoodHandle* begin = postings.data();
+    return seekHandle(begin + from, begin + postings.size(), target) - begin;
+}
+
+// The best hits after a cursor, at most `capacity` of them. A heap ordered
+// by ranksBefore keeps the weakest hit at the front, where it is replaced.
+class TopHits {
+private:
+    std::vector<RankedFood> heap;
+    size_t capacity;
+    RankedFood after;
+
+public:
+    TopHits(size_t capacity, const SearchCursor& after) : capacity(capacity), after{after.handle, after.score} {}
+
+    // Whether a food scoring at most `bound` could still displace a hit.
+    // Pass the lowest handle the food might have when it is not yet known.
+    bool canBeat(std::uint64_t bound, FoodHandle handle) const {
+        return heap.size() < capacity || ranksBefore({handle, bound}, heap.front());
     }
 
-    std::string line;
-    std::shared_ptr<CompositeFood> currentComposite = nullptr;
+    // Lowest handle a hit scoring `score` may have to come after the cursor;
+    // INVALID_FOOD_HANDLE when no such hit can
+    FoodHandle firstAfter(std::uint64_t score) const {
+        if (score < after.score) return 0;
+        if (score > after.score || after.handle == INVALID_FOOD_HANDLE) return INVALID_FOOD_HANDLE;
+        return after.handle + 1;
+    }
 
-    while (std::getline(file, line)) {
-        if (line.empty()) continue;
-        
-        if (line == "---") {
-            if (currentComposite) {
-                compositeFoods[currentComposite->getIdentifier()] = currentComposite;
-                currentComposite = nullptr;
+    void offer(FoodHandle handle, std::uint64_t score) {
+        RankedFood hit = {handle, score};
+        if (!ranksBefore(after, hit)) return;
+        if (heap.size() < capacity) {
+            heap.push_back(hit);
+            std::push_heap(heap.begin(), heap.end(), ranksBefore);
+        } else if (ranksBefore(hit, heap.front())) {
+            std::pop_heap(heap.begin(), heap.end(), ranksBefore);
+            heap.back() = hit;
+            std::push_heap(heap.begin(), heap.end(), ranksBefore);
+        }
+    }
+
+    // Best first
+    std::vector<RankedFood> take() {
+        std::sort_heap(heap.begin(), heap.end(), ranksBefore);
+        return std::move(heap);
+    }
+};
+
+struct ScoredList {
+    const std::vector<FoodHandle>* postings;
+    std::uint64_t weight;
+    size_t position;
+};
+
+// Match-any ranking (MaxScore). Lists are ordered lightest first; once the
+// page is full, the lightest lists whose weights together cannot lift a food
+// into it stop proposing candidates and are only probed, heaviest first, for
+// candidates from the others. Probing stops as soon as the weights left
+// cannot lift the candidate either.
+void rankAny(std::vector<ScoredList>& lists, TopHits& hits) {
+    std::sort(lists.begin(), lists.end(),
+              [](const ScoredList& a, const ScoredList& b) { return a.weight < b.weight; });
+    // bounds[i] is the most lists[0, i) can add to a score
+    std::vector<std::uint64_t> bounds(lists.size() + 1, 0);
+    for (size_t i = 0; i < lists.size(); ++i) bounds[i + 1] = bounds[i] + lists[i].weight;
+
+    size_t essential = 0;  // lists[0, essential) only answer probes
+    while (true) {
+        while (essential < lists.size() && !hits.canBeat(bounds[essential + 1], 0)) ++essential;
+        FoodHandle candidate = INVALID_FOOD_HANDLE;
+        for (size_t i = essential; i < lists.size(); ++i) {
+            const ScoredList& list = lists[i];
+            if (list.position < list.postings->size()) {
+                candidate = std::min(candidate, (*list.postings)[list.position]);
             }
-            continue;
         }
+        if (candidate == INVALID_FOOD_HANDLE) break;
 
-        std::stringstream ss(line);
-        std::string id, keywordStr;
-        std::vector<std::string> keywords;
+        std::uint64_t score = 0;
+        for (size_t i = essential; i < lists.size(); ++i) {
+            ScoredList& list = lists[i];
+            if (list.position < list.postings->size() && (*list.postings)[list.position] == candidate) {
+                score += list.weight;
+                ++list.position;
+            }
+        }
+        bool viable = true;
+        for (size_t i = essential; i-- > 0;) {
+            if (!hits.canBeat(score + bounds[i + 1], candidate)) {
+                viable = false;
+                break;
+            }
+            ScoredList& list = lists[i];
+            list.position = seekPosting(*list.postings, list.position, candidate);
+            if (list.position < list.postings->size() && (*list.postings)[list.position] == candidate) {
+                score += list.weight;
+            }
+        }
+        if (viable) hits.offer(candidate, score);
+    }
+}
 
-        // Read ID and keywords
-        std::getline(ss, id, '|');
-        std::getline(ss, keywordStr);
-        keywords = utils::splitString(keywordStr, ',');
+// Match-all ranking: every hit matches every list and so scores the same,
+// which leaves handle order. The rarest list drives a leapfrog intersection
+// that stops once the page is full. For an exact query `keywords` holds its
+// ids, ascending, and the rarest list's candidates are checked against food
+// signatures and keywords instead of the other lists.
+void rankAll(std::vector<ScoredList>& lists, const FoodCatalog& catalog, const std::vector<KeywordId>& keywords,
+             TopHits& hits) {
+    std::sort(lists.begin(), lists.end(), [](const ScoredList& a, const ScoredList& b) {
+        return a.postings->size() < b.postings->size();
+    });
+    std::uint64_t score = 0;
+    for (const auto& list : lists) score += list.weight;
+    FoodHandle first = hits.firstAfter(score);
+    if (first == INVALID_FOOD_HANDLE) return;
 
-        if (!currentComposite) {
-            currentComposite = std::make_shared<CompositeFood>(id, keywords);
-        } else {
-            // This is a component line
-            std::string componentId;
-            int servings;
-            std::stringstream componentSs(line);
-            std::getline(componentSs, componentId, '|');
-            componentSs >> servings;
-            
-            auto food = getFood(componentId);
-            if (food) {
-                currentComposite->addComponent(food, servings);
+    const std::vector<FoodHandle>& driver = *lists[0].postings;
+    size_t position = seekPosting(driver, 0, first);
+    if (keywords.size() > 1) {
+        std::uint64_t signature = 0;
+        for (KeywordId keyword : keywords) signature |= FoodCatalog::keywordSignature(keyword);
+        const std::uint64_t* signatures = catalog.signatureTable();
+        for (; position < driver.size(); ++position) {
+            FoodHandle candidate = driver[position];
+            if (!hits.canBeat(score, candidate)) return;
+            if ((signatures[candidate] & signature) == signature && hasKeywords(catalog, candidate, keywords)) {
+                hits.offer(candidate, score);
             }
         }
+        return;
+    }
+    while (position < driver.size()) {
+        FoodHandle candidate = driver[position];
+        if (!hits.canBeat(score, candidate)) return;
+        FoodHandle next = candidate;
+        for (size_t i = 1; i < lists.size() && next == candidate; ++i) {
+            ScoredList& list = lists[i];
+            list.position = seekPosting(*list.postings, list.position, candidate);
+            if (list.position == list.postings->size()) return;
+            next = (*list.postings)[list.position];
+        }
+        if (next == candidate) {
+            hits.offer(candidate, score);
+            ++position;
+        } else {
+            position = seekPosting(driver, position, next);
+        }
     }
+}
 
-    // Add the last composite food if exists
-    if (currentComposite) {
-        compositeFoods[currentComposite->getIdentifier()] = currentComposite;
+} // namespace
+
+Database::Database(const std::string& basicFoodsFile, const std::string& compositeFoodsFile)
+    : published(nullptr),
+      basicFoodsFile(basicFoodsFile), compositeFoodsFile(compositeFoodsFile),
+      snapshotFile((std::filesystem::path(basicFoodsFile).parent_path() / "foods.snapshot").string()),
+      journalFile((std::filesystem::path(basicFoodsFile).parent_path() / "foods.journal").string()),
+      journalRecords(0), journalBytes(0) {
+    // Parse the text files only when the binary snapshot is missing or stale
+    State& state = states[0];
+    if (!CatalogSnapshot::load(snapshotFile, *this)) {
+        FoodFileLoader::load(*this);
+        state.catalog.view();
+        published.store(&state);
+        CatalogSnapshot::write(snapshotFile, *this);
     }
+    replayJournal(state);
 
-    #ifdef DEBUG
-    std::cout << "DEBUG: Loaded " << compositeFoods.size() << " composite foods" << std::endl;
-    #endif
+    // Both copies start identical and fully resolved so readers never write
+    state.catalog.view();
+    states[1] = state;
+    published.store(&state);
+    YADA_TRACE(VERBOSE, DATABASE, "Created Database object");
 }
 
-void Database::saveBasicFoods() const {
-    std::ofstream file(basicFoodsFile);
-    if (!file.is_open()) {
-        #ifdef DEBUG
-        std::cout << "DEBUG: Could not open basic foods file for writing: " << basicFoodsFile << std::endl;
-        #endif
-        return;
+Database::Reader::Reader(utils::EpochDomain::Section section, const State* state)
+    : section(std::move(section)), state(state) {}
+
+const FoodCatalog& Database::Reader::catalog() const {
+    return state->catalog;
+}
+
+CatalogView Database::Reader::view() const {
+    return CatalogView(state->catalog);
+}
+
+Database::Reader Database::read() const {
+    // Enter the section before loading the pointer so a writer cannot reuse
+    // the copy between the two steps
+    utils::EpochDomain::Section section = epochs.enter();
+    return Reader(std::move(section), published.load());
+}
+
+void Database::checkWriter() const {
+    if (utils::EpochDomain::inSection()) {
+        // The writer would wait for its own section to end
+        throw std::logic_error("Database writes are not allowed while holding a Reader");
     }
+}
 
-    for (const auto& pair : basicFoods) {
-        const auto& food = pair.second;
-        file << food->getIdentifier() << "|" << food->getCaloriesPerServing() << "|";
-        const auto& keywords = food->getKeywords();
+template <typename Mutation>
+void Database::write(Mutation mutation) {
+    State* current = published.load();
+    State* standby = current == &states[0] ? &states[1] : &states[0];
+
+    mutation(*standby);
+    standby->catalog.view();
+    published.store(standby);
+
+    // Readers that may still see the old copy finish before it is touched
+    epochs.synchronize();
+    mutation(*current);
+    current->catalog.view();
+}
+
+bool Database::saveBasicFoods(const State& state) const {
+    const FoodCatalog& catalog = state.catalog;
+    std::ostringstream file;
+
+    for (FoodHandle handle = 0; handle < catalog.size(); ++handle) {
+        if (catalog.kind(handle) != FoodKind::BASIC) continue;
+        file << catalog.name(handle) << "|" << catalog.caloriesPerServing(handle) << "|";
+        const auto keywords = catalog.keywords(handle);
         for (size_t i = 0; i < keywords.size(); ++i) {
-            file << keywords[i];
+            file << catalog.keywordText(keywords[i]);
             if (i < keywords.size() - 1) file << ",";
         }
         file << "\n";
     }
-    #ifdef DEBUG
-    std::cout << "DEBUG: Saved " << basicFoods.size() << " basic foods" << std::endl;
-    #endif
+    // Replaced through a synced temporary file so a crash keeps the old contents
+    if (!utils::replaceFile(basicFoodsFile, nullptr, 0, file.str())) {
+        YADA_TRACE(WARNING, IO, "Could not write basic foods file: " << basicFoodsFile);
+        return false;
+    }
+    YADA_TRACE(INFO, DATABASE, "Saved " << state.basicFoodCount << " basic foods");
+    return true;
 }
 
-void Database::saveCompositeFoods() const {
-    std::ofstream file(compositeFoodsFile);
-    if (!file.is_open()) {
-        #ifdef DEBUG
-        std::cout << "DEBUG: Could not open composite foods file for writing: " << compositeFoodsFile << std::endl;
-        #endif
-        return;
-    }
+bool Database::saveCompositeFoods(const State& state) const {
+    const FoodCatalog& catalog = state.catalog;
+    std::ostringstream file;
 
-    for (const auto& pair : compositeFoods) {
-        const auto& food = pair.second;
-        file << food->getIdentifier() << "|";
-        const auto& keywords = food->getKeywords();
+    for (FoodHandle handle = 0; handle < catalog.size(); ++handle) {
+        if (catalog.kind(handle) != FoodKind::COMPOSITE) continue;
+        file << catalog.name(handle) << "|";
+        const auto keywords = catalog.keywords(handle);
         for (size_t i = 0; i < keywords.size(); ++i) {
-            file << keywords[i];
+            file << catalog.keywordText(keywords[i]);
             if (i < keywords.size() - 1) file << ",";
         }
         file << "\n";
 
         // Write components
-        const auto& components = food->getComponents();
-        for (const auto& component : components) {
-            file << component.first << "|" << component.second.second << "\n";
+        for (const auto& component : catalog.components(handle)) {
+            file << catalog.name(component.food) << "|" << component.servings << "\n";
         }
         file << "---\n";
     }
-    #ifdef DEBUG
-    std::cout << "DEBUG: Saved " << compositeFoods.size() << " composite foods" << std::endl;
-    #endif
+    if (!utils::replaceFile(compositeFoodsFile, nullptr, 0, file.str())) {
+        YADA_TRACE(WARNING, IO, "Could not write composite foods file: " << compositeFoodsFile);
+        return false;
+    }
+    YADA_TRACE(INFO, DATABASE, "Saved " << state.compositeFoodCount << " composite foods");
+    return true;
+}
+
+void Database::replayJournal(State& state) {
+    std::ifstream file(journalFile);
+    if (!file.is_open()) return;
+
+    // Applies one record; false if it is malformed
+    auto apply = [&state](const std::string& line) {
+        // B|id|calories|keywords  C|id|keywords  +|composite|component|servings
+        // S|id|calories  K|id|keywords  -|composite|component
+        auto fields = utils::splitString(line, '|');
+        if (fields.empty()) return false;
+        if (fields[0] == "B" && fields.size() >= 3) {
+            double calories;
+            if (!utils::parseDouble(fields[2], calories)) return false;
+            std::vector<std::string> keywords;
+            if (fields.size() > 3) keywords = utils::splitString(fields[3], ',');
+            state.defineBasicFood(fields[1], keywords, calories);
+        } else if (fields[0] == "C" && fields.size() >= 2) {
+            std::vector<std::string> keywords;
+            if (fields.size() > 2) keywords = utils::splitString(fields[2], ',');
+            state.defineCompositeFood(fields[1], keywords);
+        } else if (fields[0] == "+" && fields.size() == 4) {
+            int servings;
+            if (!utils::parseInt(fields[3], servings)) return false;
+            FoodHandle composite = state.findFood(fields[1]);
+            FoodHandle food = state.findFood(fields[2]);
+            if (composite != INVALID_FOOD_HANDLE && state.catalog.kind(composite) == FoodKind::COMPOSITE
+                && food != INVALID_FOOD_HANDLE) {
+                if (state.catalog.contains(food, composite)) {
+                    YADA_TRACE(WARNING, DATABASE, "Skipping cyclic journal record: " << line);
+                } else {
+                    state.catalog.addComponent(composite, food, servings);
+                }
+            }
+        } else if (fields[0] == "-" && fields.size() == 3) {
+            FoodHandle composite = state.findFood(fields[1]);
+            FoodHandle food = state.catalog.find(fields[2]);
+            if (composite != INVALID_FOOD_HANDLE && state.catalog.kind(composite) == FoodKind::COMPOSITE
+                && food != INVALID_FOOD_HANDLE) {
+                state.catalog.removeComponent(composite, food);
+            }
+        } else if (fields[0] == "S" && fields.size() == 3) {
+            double calories;
+            if (!utils::parseDouble(fields[2], calories)) return false;
+            FoodHandle food = state.findFood(fields[1]);
+            if (food != INVALID_FOOD_HANDLE && state.catalog.kind(food) == FoodKind::BASIC) {
+                state.catalog.setCalories(food, calories);
+            }
+        } else if (fields[0] == "K" && fields.size() >= 2) {
+            std::vector<std::string> keywords;
+            if (fields.size() > 2) keywords = utils::splitString(fields[2], ',');
+            FoodHandle food = state.findFood(fields[1]);
+            if (food != INVALID_FOOD_HANDLE) state.setKeywords(food, keywords);
+        } else {
+            return false;
+        }
+        return true;
+    };
+
+    std::string line;
+    bool torn = false;
+    while (std::getline(file, line)) {
+        // A last record without its newline was torn by a crash mid-append
+        if (file.eof()) {
+            YADA_TRACE(WARNING, IO, "Dropping truncated journal record: " << line);
+            torn = true;
+            break;
+        }
+        journalBytes += line.size() + 1;
+        if (line.empty()) continue;
+        ++journalRecords;
+        if (!apply(line)) YADA_TRACE(WARNING, IO, "Skipping malformed journal record: " << line);
+    }
+    file.close();
+    if (torn) {
+        // Cut the torn tail so later appends start on a fresh line
+        std::error_code ec;
+        std::filesystem::resize_file(journalFile, journalBytes, ec);
+        if (ec) YADA_TRACE(WARNING, IO, "Could not truncate journal file: " << journalFile);
+    }
+    YADA_TRACE(INFO, DATABASE, "Replayed " << journalRecords << " journal records");
+}
+
+void Database::appendJournal() {
+    if (pendingJournal.empty()) return;
+
+    std::string batch;
+    for (const auto& record : pendingJournal) {
+        batch += record;
+        batch += '\n';
+    }
+
+#ifndef _WIN32
+    // One write and one fsync for the whole batch
+    int fd = ::open(journalFile.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (fd < 0) {
+        YADA_TRACE(WARNING, IO, "Could not open journal file for writing: " << journalFile);
+        return;
+    }
+    const char* data = batch.data();
+    size_t remaining = batch.size();
+    while (remaining > 0) {
+        ssize_t written = ::write(fd, data, remaining);
+        if (written <= 0) break;
+        data += written;
+        remaining -= static_cast<size_t>(written);
+    }
+    ::fsync(fd);
+    ::close(fd);
+#else
+    std::ofstream file(journalFile, std::ios::app);
+    file << batch;
+    file.flush();
+#endif
+
+    journalRecords += pendingJournal.size();
+    journalBytes += batch.size();
+    pendingJournal.clear();
+}
+
+void Database::indexFood(KeywordIndex& index, KeywordTrie& vocabulary, const FoodCatalog& catalog,
+                         FoodHandle handle) {
+    if (index.size() < catalog.keywordTableSize()) index.resize(catalog.keywordTableSize());
+    for (KeywordId keyword : catalog.keywords(handle)) {
+        auto& postings = index[keyword];
+        if (postings.empty()) vocabulary.insert(catalog.keywordText(keyword));
+        // Handles are issued in increasing order, so this is usually an append
+        auto it = std::lower_bound(postings.begin(), postings.end(), handle);
+        if (it == postings.end() || *it != handle) {
+            postings.insert(it, handle);
+        }
+    }
+}
+
+void Database::unindexFood(KeywordIndex& index, KeywordTrie& vocabulary, const FoodCatalog& catalog,
+                           FoodHandle handle) {
+    for (KeywordId keyword : catalog.keywords(handle)) {
+        if (keyword >= index.size()) continue;
+
+        auto& postings = index[keyword];
+        auto it = std::lower_bound(postings.begin(), postings.end(), handle);
+        if (it == postings.end() || *it != handle) continue;
+        postings.erase(it);
+        if (postings.empty()) {
+            vocabulary.erase(catalog.keywordText(keyword));
+            PostingList().swap(postings);
+        }
+    }
+    if (vocabulary.sparse()) {
+        vocabulary.clear();
+        for (KeywordId keyword = 0; keyword < index.size(); ++keyword) {
+            if (!index[keyword].empty()) vocabulary.insert(catalog.keywordText(keyword));
+        }
+    }
+}
+
+int Database::fuzzyEdits(size_t length) {
+    return length < 3 ? 0 : length < 6 ? 1 : 2;
+}
+
+const Database::PostingList* Database::lookupKeyword(const KeywordIndex& index, const KeywordTrie& vocabulary,
+    const FoodCatalog& catalog, const std::string& term, KeywordMatch match, std::deque<PostingList>& expanded) {
+    if (match == KeywordMatch::EXACT) {
+        KeywordId keyword = catalog.findKeyword(term);
+        return keyword < index.size() && !index[keyword].empty() ? &index[keyword] : nullptr;
+    }
+
+    // The vocabulary holds exactly the keywords with a non-empty list
+    std::vector<const PostingList*> matches;
+    auto collect = [&](std::string_view word) {
+        matches.push_back(&index[catalog.findKeyword(word)]);
+    };
+    if (match == KeywordMatch::PREFIX) {
+        vocabulary.forEachWithPrefix(term, collect);
+    } else {
+        vocabulary.forEachWithin(term, fuzzyEdits(term.size()), collect);
+    }
+    if (matches.empty()) return nullptr;
+    if (matches.size() == 1) return matches[0];
+
+    PostingList merged;
+    PostingList scratch;
+    for (const auto* list : matches) {
+        scratch.clear();
+        std::set_union(merged.begin(), merged.end(), list->begin(), list->end(), std::back_inserter(scratch));
+        merged.swap(scratch);
+    }
+    expanded.push_back(std::move(merged));
+    return &expanded.back();
+}
+
+void Database::State::forgetDefinition(FoodHandle handle) {
+    switch (catalog.kind(handle)) {
+        case FoodKind::BASIC:
+            unindexFood(basicKeywordIndex, basicVocabulary, catalog, handle);
+            --basicFoodCount;
+            break;
+        case FoodKind::COMPOSITE:
+            unindexFood(compositeKeywordIndex, compositeVocabulary, catalog, handle);
+            --compositeFoodCount;
+            break;
+        case FoodKind::UNDEFINED:
+            break;
+    }
+}
+
+FoodHandle Database::State::defineBasicFood(const std::string& id, const std::vector<std::string>& keywords, double calories) {
+    FoodHandle handle = catalog.intern(id);
+    // Redefining keeps the handle, so composites containing this food see the change
+    forgetDefinition(handle);
+    catalog.defineBasic(handle, keywords, calories);
+    indexFood(basicKeywordIndex, basicVocabulary, catalog, handle);
+    ++basicFoodCount;
+    return handle;
+}
+
+FoodHandle Database::State::defineCompositeFood(const std::string& id, const std::vector<std::string>& keywords) {
+    FoodHandle handle = catalog.intern(id);
+    forgetDefinition(handle);
+    catalog.defineComposite(handle, keywords);
+    indexFood(compositeKeywordIndex, compositeVocabulary, catalog, handle);
+    ++compositeFoodCount;
+    return handle;
+}
+
+void Database::State::setKeywords(FoodHandle handle, const std::vector<std::string>& keywords) {
+    bool basic = catalog.kind(handle) == FoodKind::BASIC;
+    auto& index = basic ? basicKeywordIndex : compositeKeywordIndex;
+    auto& vocabulary = basic ? basicVocabulary : compositeVocabulary;
+    unindexFood(index, vocabulary, catalog, handle);
+    catalog.setKeywords(handle, keywords);
+    indexFood(index, vocabulary, catalog, handle);
+}
+
+FoodHandle Database::State::findFood(std::string_view id) const {
+    FoodHandle handle = catalog.find(id);
+    return catalog.isDefined(handle) ? handle : INVALID_FOOD_HANDLE;
 }
 
 void Database::addBasicFood(const std::string& id, const std::vector<std::string>& keywords, double calories) {
-    basicFoods[id] = std::make_shared<BasicFood>(id, keywords, calories);
-    #ifdef DEBUG
-    std::cout << "DEBUG: Added basic food: " << id << std::endl;
-    #endif
+    checkWriter();
+    std::lock_guard<std::mutex> lock(writerMutex);
+    write([&](State& state) { state.defineBasicFood(id, keywords, calories); });
+    std::ostringstream record;
+    record << "B|" << id << "|" << calories << "|" << joinKeywords(keywords);
+    pendingJournal.push_back(record.str());
+    YADA_TRACE(DETAIL, DATABASE, "Added basic food: " << id);
+}
+
+void Database::setCalories(FoodHandle food, double calories) {
+    checkWriter();
+    std::lock_guard<std::mutex> lock(writerMutex);
+    const FoodCatalog& catalog = published.load()->catalog;
+    if (catalog.kind(food) != FoodKind::BASIC) return;
+    write([&](State& state) { state.catalog.setCalories(food, calories); });
+
+    std::ostringstream record;
+    record << "S|" << catalog.name(food) << "|" << calories;
+    pendingJournal.push_back(record.str());
+    YADA_TRACE(DETAIL, DATABASE, "Updated calories for basic food " << catalog.name(food) << " to " << calories);
 }
 
 void Database::addCompositeFood(const std::string& id, const std::vector<std::string>& keywords) {
-    compositeFoods[id] = std::make_shared<CompositeFood>(id, keywords);
-    #ifdef DEBUG
-    std::cout << "DEBUG: Added composite food: " << id << std::endl;
-    #endif
+    checkWriter();
+    std::lock_guard<std::mutex> lock(writerMutex);
+    write([&](State& state) { state.defineCompositeFood(id, keywords); });
+    pendingJournal.push_back("C|" + id + "|" + joinKeywords(keywords));
+    YADA_TRACE(DETAIL, DATABASE, "Added composite food: " << id);
 }
 
-std::shared_ptr<BasicFood> Database::getBasicFood(const std::string& id) const {
-    auto it = basicFoods.find(id);
-    return it != basicFoods.end() ? it->second : nullptr;
+bool Database::addComponent(FoodHandle composite, FoodHandle food, int servings) {
+    checkWriter();
+    std::lock_guard<std::mutex> lock(writerMutex);
+    const FoodCatalog& catalog = published.load()->catalog;
+    if (catalog.kind(composite) != FoodKind::COMPOSITE || !catalog.isDefined(food)) {
+        return false;
+    }
+    if (catalog.contains(food, composite)) {
+        YADA_TRACE(WARNING, DATABASE, "Refusing to add " << catalog.name(food) << " to " << catalog.name(composite)
+                   << ": it would make the composite contain itself");
+        return false;
+    }
+    write([&](State& state) { state.catalog.addComponent(composite, food, servings); });
+
+    std::ostringstream record;
+    record << "+|" << catalog.name(composite) << "|" << catalog.name(food) << "|" << servings;
+    pendingJournal.push_back(record.str());
+    return true;
 }
 
-std::shared_ptr<CompositeFood> Database::getCompositeFood(const std::string& id) const {
-    auto it = compositeFoods.find(id);
-    return it != compositeFoods.end() ? it->second : nullptr;
+void Database::removeComponent(FoodHandle composite, FoodHandle food) {
+    checkWriter();
+    std::lock_guard<std::mutex> lock(writerMutex);
+    const FoodCatalog& catalog = published.load()->catalog;
+    if (catalog.kind(composite) != FoodKind::COMPOSITE) return;
+    write([&](State& state) { state.catalog.removeComponent(composite, food); });
+    pendingJournal.push_back("-|" + std::string(catalog.name(composite)) + "|" + std::string(catalog.name(food)));
 }
 
-std::shared_ptr<Food> Database::getFood(const std::string& id) const {
-    auto basicFood = getBasicFood(id);
-    if (basicFood) return basicFood;
-    return getCompositeFood(id);
+void Database::clearComponents(FoodHandle composite) {
+    checkWriter();
+    std::lock_guard<std::mutex> lock(writerMutex);
+    const FoodCatalog& catalog = published.load()->catalog;
+    if (catalog.kind(composite) != FoodKind::COMPOSITE) return;
+    // Journaled as one removal per component so replay needs no extra record type
+    for (const auto& component : catalog.components(composite)) {
+        pendingJournal.push_back("-|" + std::string(catalog.name(composite)) + "|"
+                                 + std::string(catalog.name(component.food)));
+    }
+    write([&](State& state) { state.catalog.clearComponents(composite); });
 }
 
-std::vector<std::shared_ptr<BasicFood>> Database::searchBasicFoods(
-    const std::vector<std::string>& keywords, bool matchAll) const {
-    std::vector<std::shared_ptr<BasicFood>> results;
-    
-    for (const auto& pair : basicFoods) {
-        const auto& food = pair.second;
-        const auto& foodKeywords = food->getKeywords();
-        
-        if (matchAll) {
-            bool matches = true;
-            for (const auto& keyword : keywords) {
-                if (std::find(foodKeywords.begin(), foodKeywords.end(), keyword) == foodKeywords.end()) {
-                    matches = false;
-                    break;
+void Database::setKeywords(FoodHandle food, const std::vector<std::string>& keywords) {
+    checkWriter();
+    std::lock_guard<std::mutex> lock(writerMutex);
+    const FoodCatalog& catalog = published.load()->catalog;
+    if (!catalog.isDefined(food)) return;
+    write([&](State& state) { state.setKeywords(food, keywords); });
+    pendingJournal.push_back("K|" + std::string(catalog.name(food)) + "|" + joinKeywords(keywords));
+}
+
+FoodHandle Database::internFood(std::string_view id) {
+    {
+        Reader reader = read();
+        FoodHandle handle = reader.catalog().find(id);
+        if (handle != INVALID_FOOD_HANDLE) return handle;
+    }
+
+    checkWriter();
+    std::lock_guard<std::mutex> lock(writerMutex);
+    // Another writer may have interned it since the lookup above
+    FoodHandle handle = published.load()->catalog.find(id);
+    if (handle != INVALID_FOOD_HANDLE) return handle;
+    write([&](State& state) { handle = state.catalog.intern(id); });
+    return handle;
+}
+
+std::shared_ptr<BasicFood> Database::getBasicFood(const std::string& id) {
+    FoodHandle handle = findFood(id);
+    if (handle == INVALID_FOOD_HANDLE || read().catalog().kind(handle) != FoodKind::BASIC) return nullptr;
+    return std::make_shared<BasicFood>(*this, handle);
+}
+
+std::shared_ptr<CompositeFood> Database::getCompositeFood(const std::string& id) {
+    FoodHandle handle = findFood(id);
+    if (handle == INVALID_FOOD_HANDLE || read().catalog().kind(handle) != FoodKind::COMPOSITE) return nullptr;
+    return std::make_shared<CompositeFood>(*this, handle);
+}
+
+std::shared_ptr<Food> Database::getFood(const std::string& id) {
+    FoodHandle handle = findFood(id);
+    if (handle == INVALID_FOOD_HANDLE) return nullptr;
+    if (read().catalog().kind(handle) == FoodKind::BASIC) return std::make_shared<BasicFood>(*this, handle);
+    return std::make_shared<CompositeFood>(*this, handle);
+}
+
+FoodHandle Database::findFood(const std::string& id) const {
+    return read().state->findFood(id);
+}
+
+Database::Matches::Matches(Reader reader, bool matchAll)
+    : reader(std::move(reader)), matchAll(matchAll), current(0), batchSize(0), batchPosition(0) {}
+
+const FoodCatalog& Database::Matches::catalog() const {
+    return reader.catalog();
+}
+
+void Database::Matches::addPass(FoodKind kind, const std::vector<std::string>& keywords, KeywordMatch match) {
+    // An empty match-all query matches every food
+    if (matchAll && keywords.empty()) {
+        passes.push_back({kind, {}, true, 0});
+        return;
+    }
+
+    const State& state = *reader.state;
+    bool basic = kind == FoodKind::BASIC;
+    const KeywordIndex& index = basic ? state.basicKeywordIndex : state.compositeKeywordIndex;
+    const KeywordTrie& vocabulary = basic ? state.basicVocabulary : state.compositeVocabulary;
+    Pass pass = {kind, {}, false, 0};
+    for (const auto& keyword : keywords) {
+        std::string term = utils::toLower(keyword);
+        const PostingList* list = lookupKeyword(index, vocabulary, state.catalog, term, match, expanded);
+        if (list) {
+            pass.cursors.push_back({list->data(), list->data() + list->size()});
+            if (matchAll && match == KeywordMatch::EXACT) pass.keywords.push_back(state.catalog.findKeyword(term));
+        } else if (matchAll) {
+            return;
+        }
+    }
+    if (pass.cursors.empty()) return;
+    if (matchAll) {
+        std::sort(pass.cursors.begin(), pass.cursors.end(), [](const Cursor& a, const Cursor& b) {
+            return a.end - a.next < b.end - b.next;
+        });
+    }
+    // Prefix and fuzzy terms stand for several keywords, which one signature cannot express
+    std::sort(pass.keywords.begin(), pass.keywords.end());
+    pass.keywords.erase(std::unique(pass.keywords.begin(), pass.keywords.end()), pass.keywords.end());
+    if (pass.keywords.size() > 1) {
+        for (KeywordId keyword : pass.keywords) pass.signature |= FoodCatalog::keywordSignature(keyword);
+        const Cursor& rarest = pass.cursors[0];
+        size_t span = rarest.end[-1] - rarest.next[0] + 1;
+        pass.dense = static_cast<size_t>(rarest.end - rarest.next) * DENSE_SCAN_RATIO >= span;
+        pass.scan = rarest.next[0];
+    }
+    passes.push_back(std::move(pass));
+}
+
+size_t Database::Matches::fillBatch(Pass& pass) {
+    size_t count = 0;
+    if (pass.everything) {
+        const FoodCatalog& catalog = reader.catalog();
+        while (count < BATCH && pass.scan < catalog.size()) {
+            FoodHandle handle = pass.scan++;
+            if (catalog.kind(handle) == pass.kind) batch[count++] = handle;
+        }
+        return count;
+    }
+
+    std::vector<Cursor>& cursors = pass.cursors;
+    if (pass.signature != 0) {
+        const FoodCatalog& catalog = reader.catalog();
+        const std::uint64_t* signatures = catalog.signatureTable();
+        Cursor& rarest = cursors[0];
+        if (!pass.dense) {
+            // Candidates come from the rarest list, so only their signatures are read
+            while (count < BATCH && rarest.next != rarest.end) {
+                FoodHandle candidate = *rarest.next++;
+                if ((signatures[candidate] & pass.signature) == pass.signature
+                    && hasKeywords(catalog, candidate, pass.keywords)) {
+                    batch[count++] = candidate;
                 }
             }
-            if (matches) results.push_back(food);
-        } else {
-            for (const auto& keyword : keywords) {
-                if (std::find(foodKeywords.begin(), foodKeywords.end(), keyword) != foodKeywords.end()) {
-                    results.push_back(food);
-                    break;
+            return count;
+        }
+        // A window of handles at a time, until one yields a match
+        FoodHandle end = rarest.end[-1] + 1;
+        while (count == 0 && pass.scan < end) {
+            size_t window = std::min<size_t>(BATCH, end - pass.scan);
+            size_t survivors = utils::selectSignatures(signatures + pass.scan, window, pass.signature, pass.scan, batch);
+            pass.scan += static_cast<FoodHandle>(window);
+            for (size_t i = 0; i < survivors; ++i) {
+                FoodHandle candidate = batch[i];
+                if (catalog.kind(candidate) == pass.kind && hasKeywords(catalog, candidate, pass.keywords)) {
+                    batch[count++] = candidate;
                 }
             }
         }
+        return count;
     }
-    
-    return results;
-}
 
-std::vector<std::shared_ptr<CompositeFood>> Database::searchCompositeFoods(
-    const std::vector<std::string>& keywords, bool matchAll) const {
-    std::vector<std::shared_ptr<CompositeFood>> results;
-    
-    for (const auto& pair : compositeFoods) {
-        const auto& food = pair.second;
-        const auto& foodKeywords = food->getKeywords();
-        
-        if (matchAll) {
-            bool matches = true;
-            for (const auto& keyword : keywords) {
-                if (std::find(foodKeywords.begin(), foodKeywords.end(), keyword) == foodKeywords.end()) {
-                    matches = false;
-                    break;
-                }
+    if (cursors.size() == 1) {
+        Cursor& cursor = cursors[0];
+        count = std::min<size_t>(BATCH, cursor.end - cursor.next);
+        std::copy_n(cursor.next, count, batch);
+        cursor.next += count;
+        return count;
+    }
+
+    if (matchAll && cursors.size() == 2 && (cursors[1].end - cursors[1].next) / 32 <= cursors[0].end - cursors[0].next) {
+        // Two lists of similar length intersect fastest in a plain merge
+        const FoodHandle* a = cursors[0].next;
+        const FoodHandle* b = cursors[1].next;
+        const FoodHandle* aEnd = cursors[0].end;
+        const FoodHandle* bEnd = cursors[1].end;
+        while (count < BATCH && a != aEnd && b != bEnd) {
+            if (*a < *b) {
+                ++a;
+            } else if (*b < *a) {
+                ++b;
+            } else {
+                batch[count++] = *a++;
+                ++b;
             }
-            if (matches) results.push_back(food);
-        } else {
-            for (const auto& keyword : keywords) {
-                if (std::find(foodKeywords.begin(), foodKeywords.end(), keyword) != foodKeywords.end()) {
-                    results.push_back(food);
-                    break;
+        }
+        cursors[0].next = a;
+        cursors[1].next = b;
+        return count;
+    }
+    if (matchAll) {
+        // Leapfrog: the rarest list proposes a handle and the others seek to it;
+        // the first one that overshoots proposes the next
+        Cursor& driver = cursors[0];
+        while (count < BATCH && driver.next != driver.end) {
+            FoodHandle candidate = *driver.next;
+            FoodHandle next = candidate;
+            for (size_t i = 1; i < cursors.size() && next == candidate; ++i) {
+                Cursor& cursor = cursors[i];
+                cursor.next = seekHandle(cursor.next, cursor.end, candidate);
+                if (cursor.next == cursor.end) {
+                    driver.next = driver.end;
+                    return count;
                 }
+                next = *cursor.next;
+            }
+            if (next == candidate) {
+                batch[count++] = candidate;
+                ++driver.next;
+            } else {
+                driver.next = seekHandle(driver.next, driver.end, next);
+            }
+        }
+        return count;
+    }
+
+    // Match-any: two lists merge directly
+    if (cursors.size() == 2) {
+        const FoodHandle* a = cursors[0].next;
+        const FoodHandle* b = cursors[1].next;
+        const FoodHandle* aEnd = cursors[0].end;
+        const FoodHandle* bEnd = cursors[1].end;
+        while (count < BATCH && a != aEnd && b != bEnd) {
+            if (*a < *b) {
+                batch[count++] = *a++;
+            } else if (*b < *a) {
+                batch[count++] = *b++;
+            } else {
+                batch[count++] = *a++;
+                ++b;
             }
         }
+        // Once one list is done the rest of the other is copied as it is
+        const FoodHandle*& rest = a != aEnd ? a : b;
+        size_t tail = std::min<size_t>(BATCH - count, (a != aEnd ? aEnd : bEnd) - rest);
+        std::copy_n(rest, tail, batch + count);
+        rest += tail;
+        count += tail;
+        cursors[0].next = a;
+        cursors[1].next = b;
+        return count;
+    }
+
+    // More lists are unioned one window of handles at a time: each list marks
+    // its handles in the window in a bitmap, which is read back in order
+    FoodHandle low = INVALID_FOOD_HANDLE;
+    for (const auto& cursor : cursors) {
+        if (cursor.next != cursor.end) low = std::min(low, *cursor.next);
+    }
+    if (low == INVALID_FOOD_HANDLE) return 0;
+    std::uint64_t high = std::uint64_t(low) + BATCH;
+    std::uint64_t words[BATCH / 64] = {};
+    for (auto& cursor : cursors) {
+        for (; cursor.next != cursor.end && *cursor.next < high; ++cursor.next) {
+            FoodHandle offset = *cursor.next - low;
+            words[offset / 64] |= std::uint64_t(1) << (offset % 64);
+        }
+    }
+    for (size_t i = 0; i < BATCH / 64; ++i) {
+        for (std::uint64_t word = words[i]; word != 0; word &= word - 1) {
+            batch[count++] = low + static_cast<FoodHandle>(i * 64 + lowestBit(word));
+        }
+    }
+    return count;
+}
+
+FoodHandle Database::Matches::refill() {
+    batchPosition = 0;
+    batchSize = 0;
+    while (current < passes.size()) {
+        batchSize = fillBatch(passes[current]);
+        if (batchSize > 0) return batch[batchPosition++];
+        ++current;
+    }
+    return INVALID_FOOD_HANDLE;
+}
+
+Database::Matches Database::matchFoods(const std::vector<std::string>& keywords, bool matchAll,
+                                       KeywordMatch match) const {
+    Matches matches(read(), matchAll);
+    if (YADA_TRACE_ON(DETAIL, SEARCH)) {
+        const State& state = *matches.reader.state;
+        std::ostringstream terms;
+        for (const auto& kw : keywords) {
+            terms << kw << " ";
+        }
+        YADA_TRACE(DETAIL, SEARCH, "Searching for keywords: " << terms.str() << "matchAll=" << matchAll
+                   << " match=" << static_cast<int>(match)
+                   << " across " << state.basicFoodCount << " basic and " << state.compositeFoodCount
+                   << " composite foods");
+    }
+    // Basic foods first, then composites
+    matches.addPass(FoodKind::BASIC, keywords, match);
+    matches.addPass(FoodKind::COMPOSITE, keywords, match);
+    return matches;
+}
+
+Database::Matches Database::matchFoods(FoodKind kind, const std::vector<std::string>& keywords, bool matchAll,
+                                       KeywordMatch match) const {
+    Matches matches(read(), matchAll);
+    matches.addPass(kind, keywords, match);
+    return matches;
+}
+
+std::vector<std::shared_ptr<BasicFood>> Database::searchBasicFoods(
+    const std::vector<std::string>& keywords, bool matchAll, KeywordMatch match) {
+    std::vector<std::shared_ptr<BasicFood>> results;
+    for (FoodHandle handle : matchFoods(FoodKind::BASIC, keywords, matchAll, match)) {
+        results.push_back(std::make_shared<BasicFood>(*this, handle));
     }
-    
     return results;
 }
 
-std::vector<std::shared_ptr<Food>> Database::searchAllFoods(
-    const std::vector<std::string>& keywords, bool matchAll) const {
-    #ifdef DEBUG
-    std::cout << "DEBUG: Searching for keywords: ";
-    for (const auto& kw : keywords) {
-        std::cout << kw << " ";
+std::vector<std::shared_ptr<CompositeFood>> Database::searchCompositeFoods(
+    const std::vector<std::string>& keywords, bool matchAll, KeywordMatch match) {
+    std::vector<std::shared_ptr<CompositeFood>> results;
+    for (FoodHandle handle : matchFoods(FoodKind::COMPOSITE, keywords, matchAll, match)) {
+        results.push_back(std::make_shared<CompositeFood>(*this, handle));
     }
-    std::cout << "matchAll=" << matchAll << std::endl;
-    std::cout << "DEBUG: Total basic foods: " << basicFoods.size() << std::endl;
-    std::cout << "DEBUG: Total composite foods: " << compositeFoods.size() << std::endl;
-    #endif
+    return results;
+}
+
+std::vector<FoodHandle> Database::searchFoodHandles(
+    const std::vector<std::string>& keywords, bool matchAll, KeywordMatch match) const {
+    std::vector<FoodHandle> results;
+    for (FoodHandle handle : matchFoods(keywords, matchAll, match)) {
+        results.push_back(handle);
+    }
+    YADA_TRACE(DETAIL, SEARCH, "Found " << results.size() << " matching foods");
+    return results;
+}
 
+std::vector<std::shared_ptr<Food>> Database::searchAllFoods(
+    const std::vector<std::string>& keywords, bool matchAll, KeywordMatch match) {
+    Matches matches = matchFoods(keywords, matchAll, match);
     std::vector<std::shared_ptr<Food>> results;
-    
-    // Search basic foods
-    for (const auto& [id, food] : basicFoods) {
-        bool matches = matchAll;
-        for (const auto& keyword : keywords) {
-            bool found = false;
-            for (const auto& foodKeyword : food->getKeywords()) {
-                #ifdef DEBUG
-                std::cout << "DEBUG: Comparing search keyword '" << keyword 
-                          << "' with food keyword '" << foodKeyword << "'" << std::endl;
-                #endif
-                if (utils::toLower(foodKeyword) == utils::toLower(keyword)) {
-                    found = true;
-                    break;
-                }
-            }
-            if (matchAll && !found) {
-                matches = false;
-                break;
-            } else if (!matchAll && found) {
-                matches = true;
-                break;
-            }
-        }
-        if (matches) {
-            results.push_back(food);
+    for (FoodHandle handle : matches) {
+        if (matches.catalog().kind(handle) == FoodKind::BASIC) {
+            results.push_back(std::make_shared<BasicFood>(*this, handle));
+        } else {
+            results.push_back(std::make_shared<CompositeFood>(*this, handle));
         }
     }
+    return results;
+}
 
-    // Search composite foods
-    for (const auto& [id, food] : compositeFoods) {
-        bool matches = matchAll;
-        for (const auto& keyword : keywords) {
-            bool found = false;
-            for (const auto& foodKeyword : food->getKeywords()) {
-                #ifdef DEBUG
-                std::cout << "DEBUG: Comparing search keyword '" << keyword 
-                          << "' with food keyword '" << foodKeyword << "'" << std::endl;
-                #endif
-                if (utils::toLower(foodKeyword) == utils::toLower(keyword)) {
-                    found = true;
-                    break;
-                }
+RankedPage Database::searchRanked(const std::vector<std::string>& keywords, bool matchAll, size_t limit,
+                                  const SearchCursor& after, KeywordMatch match) const {
+    RankedPage page;
+    page.next = after;
+    if (limit == 0) return page;
+
+    Reader reader = read();
+    const State& state = *reader.state;
+    // One hit more than the page tells whether another page follows
+    TopHits hits(limit + 1, after);
+
+    if (matchAll && keywords.empty()) {
+        // Every food matches with nothing to score, so handle order decides
+        for (FoodHandle handle = hits.firstAfter(0); handle < state.catalog.size(); ++handle) {
+            if (!hits.canBeat(0, handle)) break;
+            if (state.catalog.isDefined(handle)) hits.offer(handle, 0);
+        }
+    } else {
+        std::vector<std::string> terms;
+        for (const auto& keyword : keywords) terms.push_back(utils::toLower(keyword));
+        std::sort(terms.begin(), terms.end());
+        terms.erase(std::unique(terms.begin(), terms.end()), terms.end());
+
+        // Each keyword's lists in both indexes, weighted by its rarity across the whole catalog
+        const KeywordIndex* indexes[2] = {&state.basicKeywordIndex, &state.compositeKeywordIndex};
+        const KeywordTrie* vocabularies[2] = {&state.basicVocabulary, &state.compositeVocabulary};
+        std::vector<ScoredList> lists[2];
+        bool complete[2] = {true, true};  // whether every keyword occurs in the index
+        std::deque<PostingList> expanded;
+        size_t foodCount = state.basicFoodCount + state.compositeFoodCount;
+        for (const auto& term : terms) {
+            const PostingList* found[2];
+            size_t matches = 0;
+            for (int kind = 0; kind < 2; ++kind) {
+                found[kind] = lookupKeyword(*indexes[kind], *vocabularies[kind], state.catalog, term, match, expanded);
+                if (found[kind]) matches += found[kind]->size();
             }
-            if (matchAll && !found) {
-                matches = false;
-                break;
-            } else if (!matchAll && found) {
-                matches = true;
-                break;
+            std::uint64_t weight = keywordWeight(matches, foodCount);
+            for (int kind = 0; kind < 2; ++kind) {
+                if (found[kind]) lists[kind].push_back({found[kind], weight, 0});
+                else complete[kind] = false;
             }
         }
-        if (matches) {
-            results.push_back(food);
+        std::vector<KeywordId> exact;
+        if (matchAll && match == KeywordMatch::EXACT) {
+            for (const auto& term : terms) exact.push_back(state.catalog.findKeyword(term));
+            std::sort(exact.begin(), exact.end());
+        }
+        for (int kind = 0; kind < 2; ++kind) {
+            if (lists[kind].empty()) continue;
+            if (!matchAll) rankAny(lists[kind], hits);
+            else if (complete[kind]) rankAll(lists[kind], state.catalog, exact, hits);
         }
     }
 
-    #ifdef DEBUG
-    std::cout << "DEBUG: Found " << results.size() << " matching foods" << std::endl;
-    #endif
+    page.foods = hits.take();
+    if (page.foods.size() > limit) {
+        page.foods.resize(limit);
+        page.more = true;
+    }
+    if (!page.foods.empty()) page.next = {page.foods.back().score, page.foods.back().handle};
+    YADA_TRACE(DETAIL, SEARCH, "Ranked search returned " << page.foods.size() << " foods"
+               << (page.more ? ", more to follow" : ""));
+    return page;
+}
 
-    return results;
+void Database::save() {
+    std::lock_guard<std::mutex> lock(writerMutex);
+    appendJournal();
+    if (journalRecords >= JOURNAL_COMPACT_RECORDS || journalBytes >= JOURNAL_COMPACT_BYTES) {
+        compactLocked();
+    }
 }
 
-void Database::save() const {
-    saveBasicFoods();
-    saveCompositeFoods();
-    #ifdef DEBUG
-    std::cout << "DEBUG: Saved all foods to database files" << std::endl;
-    #endif
+void Database::compact() {
+    std::lock_guard<std::mutex> lock(writerMutex);
+    compactLocked();
 }
 
-std::map<std::string, std::shared_ptr<Food>> Database::getAllFoods() const {
-    std::map<std::string, std::shared_ptr<Food>> allFoods;
-    
-    // Add basic foods
-    for (const auto& [id, food] : basicFoods) {
-        allFoods[id] = food;
-    }
-    
-    // Add composite foods
-    for (const auto& [id, food] : compositeFoods) {
-        allFoods[id] = food;
+void Database::compactLocked() {
+    // The published copy only changes under writerMutex, which we hold
+    const State& state = *published.load();
+    if (!saveBasicFoods(state) || !saveCompositeFoods(state) || !CatalogSnapshot::write(snapshotFile, *this)) {
+        // The journal is kept, with anything pending added. Replaying it over
+        // files that were already rewritten is harmless: every record sets
+        // state rather than adding to it.
+        appendJournal();
+        YADA_TRACE(WARNING, DATABASE, "Compaction failed; keeping the journal");
+        return;
     }
-    
-    return allFoods;
+
+    // The base files now contain everything, so the journal starts over
+    std::ofstream(journalFile, std::ios::trunc);
+    pendingJournal.clear();
+    journalRecords = 0;
+    journalBytes = 0;
+    YADA_TRACE(INFO, DATABASE, "Saved all foods to database files");
 }
 
-#ifdef DEBUG
 void Database::debugPrint() const {
-    std::cout << "DEBUG: Database Contents:" << std::endl;
-    std::cout << "Basic Foods:" << std::endl;
-    for (const auto& pair : basicFoods) {
-        pair.second->debugPrint();
+    if (!YADA_TRACE_ON(VERBOSE, DATABASE)) return;
+
+    Reader reader = read();
+    const FoodCatalog& catalog = reader.catalog();
+    auto printFood = [&](std::ostream& out, FoodHandle handle) {
+        out << "Food Object:\n";
+        out << "  ID: " << catalog.name(handle) << "\n";
+        out << "  Keywords: ";
+        for (KeywordId keyword : catalog.keywords(handle)) {
+            out << catalog.keywordText(keyword) << " ";
+        }
+        out << "\n";
+        out << "  Calories per serving: " << catalog.caloriesPerServing(handle) << "\n";
+    };
+
+    std::ostringstream out;
+    out << "Database Contents:\n";
+    out << "Basic Foods:\n";
+    for (FoodHandle handle = 0; handle < catalog.size(); ++handle) {
+        if (catalog.kind(handle) == FoodKind::BASIC) printFood(out, handle);
     }
-    std::cout << "\nComposite Foods:" << std::endl;
-    for (const auto& pair : compositeFoods) {
-        pair.second->debugPrint();
+    out << "\nComposite Foods:\n";
+    for (FoodHandle handle = 0; handle < catalog.size(); ++handle) {
+        if (catalog.kind(handle) != FoodKind::COMPOSITE) continue;
+        printFood(out, handle);
+        out << "  Components:\n";
+        for (const auto& component : catalog.components(handle)) {
+            out << "    - " << catalog.name(component.food)
+                << " (" << component.servings << " servings)\n";
+        }
     }
+    YADA_TRACE(VERBOSE, DATABASE, out.str());
 }
-#endif 
\ No newline at end of file
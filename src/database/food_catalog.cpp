@@ -0,0 +1,399 @@
+#include "database/food_catalog.h"
+#include "utils/thread_pool.h"
+#include "utils/trace.h"
+#include "utils/utils.h"
+#include <algorithm>
+
+FoodCatalog::FoodCatalog()
+    : nameOffsets(1, 0), keywordTextOffsets(1, 0), deadKeywords(0), deadComponents(0), calorieRevision(0) {
+    rehash(16);
+    rehashKeywords(16);
+}
+
+std::uint64_t FoodCatalog::hashName(std::string_view id) {
+    // FNV-1a
+    std::uint64_t hash = 14695981039346656037ull;
+    for (char c : id) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+size_t FoodCatalog::findSlot(std::string_view id) const {
+    size_t mask = slots.size() - 1;
+    size_t slot = hashName(id) & mask;
+    while (slots[slot] != INVALID_FOOD_HANDLE && name(slots[slot]) != id) {
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+void FoodCatalog::rehash(size_t slotCount) {
+    slots.assign(slotCount, INVALID_FOOD_HANDLE);
+    for (FoodHandle handle = 0; handle < kinds.size(); ++handle) {
+        slots[findSlot(name(handle))] = handle;
+    }
+}
+
+size_t FoodCatalog::findKeywordSlot(std::string_view keyword) const {
+    size_t mask = keywordSlots.size() - 1;
+    size_t slot = hashName(keyword) & mask;
+    while (keywordSlots[slot] != INVALID_KEYWORD && keywordText(keywordSlots[slot]) != keyword) {
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+void FoodCatalog::rehashKeywords(size_t slotCount) {
+    keywordSlots.assign(slotCount, INVALID_KEYWORD);
+    for (KeywordId keyword = 0; keyword < keywordTableSize(); ++keyword) {
+        keywordSlots[findKeywordSlot(keywordText(keyword))] = keyword;
+    }
+}
+
+KeywordId FoodCatalog::internKeyword(std::string_view keyword) {
+    std::string lower = utils::toLower(std::string(keyword));
+    size_t slot = findKeywordSlot(lower);
+    if (keywordSlots[slot] != INVALID_KEYWORD) return keywordSlots[slot];
+
+    KeywordId id = static_cast<KeywordId>(keywordTableSize());
+    keywordArena += lower;
+    keywordTextOffsets.push_back(static_cast<std::uint32_t>(keywordArena.size()));
+    if (keywordTableSize() * 2 > keywordSlots.size()) {
+        rehashKeywords(keywordSlots.size() * 2);
+    } else {
+        keywordSlots[slot] = id;
+    }
+    return id;
+}
+
+KeywordId FoodCatalog::findKeyword(std::string_view keyword) const {
+    return keywordSlots[findKeywordSlot(keyword)];
+}
+
+std::string_view FoodCatalog::keywordText(KeywordId keyword) const {
+    return std::string_view(keywordArena.data() + keywordTextOffsets[keyword],
+                            keywordTextOffsets[keyword + 1] - keywordTextOffsets[keyword]);
+}
+
+size_t FoodCatalog::keywordTableSize() const {
+    return keywordTextOffsets.size() - 1;
+}
+
+std::uint64_t FoodCatalog::keywordSignature(KeywordId keyword) {
+    // Two bits per keyword, taken from the top of a Fibonacci hash
+    std::uint64_t hash = (std::uint64_t(keyword) + 1) * 0x9E3779B97F4A7C15ull;
+    return (std::uint64_t(1) << (hash >> 58)) | (std::uint64_t(1) << ((hash >> 52) & 63));
+}
+
+FoodHandle FoodCatalog::intern(std::string_view id) {
+    size_t slot = findSlot(id);
+    if (slots[slot] != INVALID_FOOD_HANDLE) return slots[slot];
+
+    FoodHandle handle = static_cast<FoodHandle>(kinds.size());
+    nameArena.append(id.data(), id.size());
+    nameOffsets.push_back(static_cast<std::uint32_t>(nameArena.size()));
+    kinds.push_back(FoodKind::UNDEFINED);
+    calories.push_back(0.0);
+    caloriesValid.push_back(1);
+    keywordOffsets.push_back(static_cast<std::uint32_t>(keywordPool.size()));
+    keywordCounts.push_back(0);
+    keywordSignatures.push_back(0);
+    componentOffsets.push_back(static_cast<std::uint32_t>(componentPool.size()));
+    componentCounts.push_back(0);
+    dependents.emplace_back();
+
+    // Keep the load factor at or below one half
+    if ((kinds.size() * 2) > slots.size()) {
+        rehash(slots.size() * 2);
+    } else {
+        slots[slot] = handle;
+    }
+    return handle;
+}
+
+FoodHandle FoodCatalog::find(std::string_view id) const {
+    return slots[findSlot(id)];
+}
+
+size_t FoodCatalog::size() const {
+    return kinds.size();
+}
+
+std::uint64_t FoodCatalog::revision() const {
+    return calorieRevision;
+}
+
+CatalogView FoodCatalog::view() const {
+    if (!staleRows.empty()) resolveCalories();
+    return CatalogView(*this);
+}
+
+// Kahn's algorithm over the stale composites: a row is computed once none of
+// its components is stale any more. Rows that become ready together only read
+// finished rows, so large levels are split across the thread pool.
+void FoodCatalog::resolveCalories() const {
+    std::sort(staleRows.begin(), staleRows.end());
+    staleRows.erase(std::unique(staleRows.begin(), staleRows.end()), staleRows.end());
+    if (pendingComponents.size() < kinds.size()) pendingComponents.resize(kinds.size(), 0);
+
+    std::vector<FoodHandle> level;
+    size_t staleCount = 0;
+    for (FoodHandle handle : staleRows) {
+        if (caloriesValid[handle]) continue;  // redefined as a basic food meanwhile
+        ++staleCount;
+        std::uint32_t pending = 0;
+        for (const auto& component : components(handle)) {
+            if (!caloriesValid[component.food]) ++pending;
+        }
+        pendingComponents[handle] = pending;
+        if (pending == 0) level.push_back(handle);
+    }
+
+    auto resolveRow = [this](FoodHandle handle) {
+        double total = 0.0;
+        for (const auto& component : components(handle)) {
+            total += calories[component.food] * component.servings;
+        }
+        calories[handle] = total;
+    };
+
+    size_t resolved = 0;
+    std::vector<FoodHandle> next;
+    while (!level.empty()) {
+        if (level.size() >= 2 * PARALLEL_RESOLVE_ROWS) {
+            size_t blocks = (level.size() + PARALLEL_RESOLVE_ROWS - 1) / PARALLEL_RESOLVE_ROWS;
+            utils::ThreadPool::shared().parallelFor(blocks, [&](size_t block) {
+                size_t end = std::min(level.size(), (block + 1) * PARALLEL_RESOLVE_ROWS);
+                for (size_t i = block * PARALLEL_RESOLVE_ROWS; i < end; ++i) {
+                    resolveRow(level[i]);
+                }
+            });
+        } else {
+            for (FoodHandle handle : level) {
+                resolveRow(handle);
+            }
+        }
+
+        next.clear();
+        for (FoodHandle handle : level) {
+            caloriesValid[handle] = 1;
+            for (FoodHandle dependent : dependents[handle]) {
+                if (!caloriesValid[dependent] && --pendingComponents[dependent] == 0) {
+                    next.push_back(dependent);
+                }
+            }
+        }
+        resolved += level.size();
+        level.swap(next);
+    }
+
+    if (resolved < staleCount) {
+        // Only reachable with a catalog built before cycles were rejected;
+        // sum whatever the cycle members currently hold rather than loop
+        YADA_TRACE(WARNING, DATABASE, (staleCount - resolved)
+                   << " composite foods are part of a component cycle; their calories are not exact");
+        for (FoodHandle handle : staleRows) {
+            if (caloriesValid[handle]) continue;
+            resolveRow(handle);
+            caloriesValid[handle] = 1;
+            pendingComponents[handle] = 0;
+        }
+    }
+    staleRows.clear();
+}
+
+std::string_view FoodCatalog::name(FoodHandle handle) const {
+    return std::string_view(nameArena.data() + nameOffsets[handle],
+                            nameOffsets[handle + 1] - nameOffsets[handle]);
+}
+
+FoodKind FoodCatalog::kind(FoodHandle handle) const {
+    return kinds[handle];
+}
+
+bool FoodCatalog::isDefined(FoodHandle handle) const {
+    return handle < kinds.size() && kinds[handle] != FoodKind::UNDEFINED;
+}
+
+double FoodCatalog::caloriesPerServing(FoodHandle handle) const {
+    if (!caloriesValid[handle]) resolveCalories();
+    return calories[handle];
+}
+
+utils::Span<const KeywordId> FoodCatalog::keywords(FoodHandle handle) const {
+    return {keywordPool.data() + keywordOffsets[handle], keywordCounts[handle]};
+}
+
+utils::Span<const FoodComponent> FoodCatalog::components(FoodHandle handle) const {
+    return {componentPool.data() + componentOffsets[handle], componentCounts[handle]};
+}
+
+bool FoodCatalog::contains(FoodHandle food, FoodHandle part) const {
+    if (food == part) return true;
+    std::vector<bool> seen(kinds.size(), false);
+    std::vector<FoodHandle> work{food};
+    seen[food] = true;
+    while (!work.empty()) {
+        FoodHandle row = work.back();
+        work.pop_back();
+        for (const auto& component : components(row)) {
+            if (component.food == part) return true;
+            if (!seen[component.food]) {
+                seen[component.food] = true;
+                work.push_back(component.food);
+            }
+        }
+    }
+    return false;
+}
+
+void FoodCatalog::defineBasic(FoodHandle handle, const std::vector<std::string>& keywords, double calories) {
+    if (kinds[handle] == FoodKind::COMPOSITE) {
+        clearComponents(handle);
+    }
+    kinds[handle] = FoodKind::BASIC;
+    setKeywords(handle, keywords);
+    setCalories(handle, calories);
+}
+
+void FoodCatalog::defineComposite(FoodHandle handle, const std::vector<std::string>& keywords) {
+    kinds[handle] = FoodKind::COMPOSITE;
+    setKeywords(handle, keywords);
+    clearComponents(handle);
+}
+
+void FoodCatalog::setKeywords(FoodHandle handle, const std::vector<std::string>& keywords) {
+    std::vector<KeywordId> ids;
+    ids.reserve(keywords.size());
+    for (const auto& keyword : keywords) {
+        ids.push_back(internKeyword(keyword));
+    }
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+
+    std::uint32_t oldCount = keywordCounts[handle];
+    if (ids.size() > oldCount) {
+        // Relocate the span to the end of the pool; the old slots are reclaimed by compaction
+        deadKeywords += oldCount;
+        keywordOffsets[handle] = static_cast<std::uint32_t>(keywordPool.size());
+        keywordPool.insert(keywordPool.end(), ids.begin(), ids.end());
+    } else {
+        deadKeywords += oldCount - ids.size();
+        std::copy(ids.begin(), ids.end(), keywordPool.begin() + keywordOffsets[handle]);
+    }
+    keywordCounts[handle] = static_cast<std::uint32_t>(ids.size());
+    std::uint64_t signature = 0;
+    for (KeywordId id : ids) signature |= keywordSignature(id);
+    keywordSignatures[handle] = signature;
+    compactPools();
+}
+
+void FoodCatalog::setCalories(FoodHandle handle, double calories) {
+    this->calories[handle] = calories;
+    caloriesValid[handle] = 1;
+    invalidate(handle);
+}
+
+void FoodCatalog::addComponent(FoodHandle composite, FoodHandle food, int servings) {
+    std::uint32_t offset = componentOffsets[composite];
+    std::uint32_t count = componentCounts[composite];
+    for (std::uint32_t i = offset; i < offset + count; ++i) {
+        if (componentPool[i].food == food) {
+            componentPool[i].servings = servings;
+            invalidate(composite);
+            return;
+        }
+    }
+
+    if (offset + count != componentPool.size()) {
+        // Not at the tail of the pool, so move the span there before growing it
+        std::vector<FoodComponent> span(componentPool.begin() + offset,
+                                        componentPool.begin() + offset + count);
+        componentOffsets[composite] = static_cast<std::uint32_t>(componentPool.size());
+        componentPool.insert(componentPool.end(), span.begin(), span.end());
+        deadComponents += count;
+    }
+    componentPool.push_back({food, servings});
+    componentCounts[composite] = count + 1;
+
+    auto& edges = dependents[food];
+    if (std::find(edges.begin(), edges.end(), composite) == edges.end()) {
+        edges.push_back(composite);
+    }
+    invalidate(composite);
+    compactPools();
+}
+
+void FoodCatalog::removeComponent(FoodHandle composite, FoodHandle food) {
+    auto begin = componentPool.begin() + componentOffsets[composite];
+    auto end = begin + componentCounts[composite];
+    auto it = std::find_if(begin, end, [food](const FoodComponent& c) { return c.food == food; });
+    if (it == end) return;
+
+    std::copy(it + 1, end, it);
+    --componentCounts[composite];
+    ++deadComponents;
+    removeDependent(food, composite);
+    invalidate(composite);
+}
+
+void FoodCatalog::clearComponents(FoodHandle composite) {
+    for (const auto& component : components(composite)) {
+        removeDependent(component.food, composite);
+    }
+    deadComponents += componentCounts[composite];
+    componentCounts[composite] = 0;
+    invalidate(composite);
+}
+
+void FoodCatalog::invalidate(FoodHandle handle) {
+    ++calorieRevision;
+    // Explicit stack: dependency chains can be deeper than the call stack
+    std::vector<FoodHandle> work{handle};
+    while (!work.empty()) {
+        FoodHandle row = work.back();
+        work.pop_back();
+        if (kinds[row] == FoodKind::COMPOSITE) {
+            // A stale composite already has stale dependents, so the walk stops here
+            if (!caloriesValid[row]) continue;
+            caloriesValid[row] = 0;
+            staleRows.push_back(row);
+        }
+        work.insert(work.end(), dependents[row].begin(), dependents[row].end());
+    }
+}
+
+void FoodCatalog::removeDependent(FoodHandle food, FoodHandle composite) {
+    auto& edges = dependents[food];
+    edges.erase(std::remove(edges.begin(), edges.end(), composite), edges.end());
+}
+
+void FoodCatalog::compactPools() {
+    const size_t minWaste = 1024;
+
+    if (deadKeywords > minWaste && deadKeywords > keywordPool.size() / 2) {
+        std::vector<KeywordId> pool;
+        pool.reserve(keywordPool.size() - deadKeywords);
+        for (size_t h = 0; h < kinds.size(); ++h) {
+            auto first = keywordPool.begin() + keywordOffsets[h];
+            keywordOffsets[h] = static_cast<std::uint32_t>(pool.size());
+            pool.insert(pool.end(), first, first + keywordCounts[h]);
+        }
+        keywordPool.swap(pool);
+        deadKeywords = 0;
+    }
+
+    if (deadComponents > minWaste && deadComponents > componentPool.size() / 2) {
+        std::vector<FoodComponent> pool;
+        pool.reserve(componentPool.size() - deadComponents);
+        for (size_t h = 0; h < kinds.size(); ++h) {
+            auto first = componentPool.begin() + componentOffsets[h];
+            componentOffsets[h] = static_cast<std::uint32_t>(pool.size());
+            pool.insert(pool.end(), first, first + componentCounts[h]);
+        }
+        componentPool.swap(pool);
+        deadComponents = 0;
+    }
+}
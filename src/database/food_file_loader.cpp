@@ -0,0 +1,320 @@
+#include "database/food_file_loader.h"
+#include "database/database.h"
+#include "utils/field_reader.h"
+#include "utils/mapped_file.h"
+#include "utils/thread_pool.h"
+#include "utils/trace.h"
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace {
+
+struct BasicRecord {
+    std::string_view id;
+    double calories;
+    std::uint32_t keywordOffset;
+    std::uint32_t keywordCount;
+};
+
+struct BasicChunk {
+    std::vector<BasicRecord> records;
+    std::vector<std::string_view> keywords;
+    size_t malformed = 0;
+};
+
+struct ComponentRef {
+    std::string_view food;
+    int servings;
+};
+
+struct CompositeRecord {
+    std::string_view id;
+    std::uint32_t keywordOffset;
+    std::uint32_t keywordCount;
+    std::uint32_t componentOffset;
+    std::uint32_t componentCount;
+    FoodHandle handle;
+};
+
+struct CompositeChunk {
+    std::vector<CompositeRecord> records;
+    std::vector<std::string_view> keywords;
+    std::vector<ComponentRef> components;
+    std::vector<FoodHandle> resolved;
+    // Set for components that would close a cycle; they are not added
+    std::vector<std::uint8_t> cyclic;
+    size_t malformed = 0;
+};
+
+// The record that defines a composite; a later record for the same id wins
+struct Definition {
+    CompositeChunk* chunk = nullptr;
+    const CompositeRecord* record = nullptr;
+};
+
+// Same rules as utils::splitString: empty items are skipped, the rest trimmed
+std::uint32_t appendKeywords(std::string_view field, std::vector<std::string_view>& keywords) {
+    std::uint32_t count = 0;
+    utils::FieldReader reader(field);
+    while (!reader.atEnd()) {
+        std::string_view item = reader.next(',');
+        if (item.empty()) continue;
+        keywords.push_back(utils::trimView(item));
+        ++count;
+    }
+    return count;
+}
+
+bool isSeparator(std::string_view line) {
+    return line == "---";
+}
+
+// Offset just past the line containing `from`, or the end of the text
+size_t nextLineStart(std::string_view text, size_t from) {
+    size_t end = text.find('\n', from);
+    return end == std::string_view::npos ? text.size() : end + 1;
+}
+
+// Cuts `text` into about `target` pieces. Basic foods can be cut at any line;
+// composite records span several lines, so those cuts go after a "---" line.
+std::vector<std::string_view> splitChunks(std::string_view text, size_t target, bool atSeparators) {
+    std::vector<std::string_view> chunks;
+    size_t chunkSize = std::max(FoodFileLoader::MIN_CHUNK_BYTES, text.size() / std::max<size_t>(target, 1) + 1);
+    size_t start = 0;
+    while (start < text.size()) {
+        size_t end = text.size();
+        if (start + chunkSize < text.size()) {
+            end = nextLineStart(text, start + chunkSize);
+            // Move the cut to just after the next "---" line
+            while (atSeparators && end < text.size()) {
+                size_t next = nextLineStart(text, end);
+                std::string_view line = text.substr(end, next - end);
+                while (!line.empty() && (line.back() == '\n' || line.back() == '\r')) {
+                    line.remove_suffix(1);
+                }
+                end = next;
+                if (isSeparator(line)) break;
+            }
+        }
+        chunks.push_back(text.substr(start, end - start));
+        start = end;
+    }
+    return chunks;
+}
+
+void parseBasicChunk(std::string_view text, BasicChunk& chunk) {
+    std::string_view line;
+    while (utils::nextLine(text, line)) {
+        if (line.empty()) continue;
+
+        // id|calories|keywords
+        utils::FieldReader fields(line);
+        BasicRecord record;
+        record.id = fields.next('|');
+        if (!utils::parseDouble(fields.next('|'), record.calories)) {
+            ++chunk.malformed;
+            continue;
+        }
+        record.keywordOffset = static_cast<std::uint32_t>(chunk.keywords.size());
+        record.keywordCount = appendKeywords(fields.remainder(), chunk.keywords);
+        chunk.records.push_back(record);
+    }
+}
+
+void parseCompositeChunk(std::string_view text, CompositeChunk& chunk) {
+    std::string_view line;
+    CompositeRecord* current = nullptr;
+    while (utils::nextLine(text, line)) {
+        if (line.empty()) continue;
+
+        if (isSeparator(line)) {
+            current = nullptr;
+            continue;
+        }
+
+        utils::FieldReader fields(line);
+        if (!current) {
+            // id|keywords, then component lines until "---"
+            CompositeRecord record;
+            record.id = fields.next('|');
+            record.keywordOffset = static_cast<std::uint32_t>(chunk.keywords.size());
+            record.keywordCount = appendKeywords(fields.remainder(), chunk.keywords);
+            record.componentOffset = static_cast<std::uint32_t>(chunk.components.size());
+            record.componentCount = 0;
+            record.handle = INVALID_FOOD_HANDLE;
+            chunk.records.push_back(record);
+            current = &chunk.records.back();
+        } else {
+            // component|servings
+            ComponentRef component;
+            component.food = fields.next('|');
+            if (!utils::parseInt(fields.remainder(), component.servings)) {
+                ++chunk.malformed;
+                continue;
+            }
+            chunk.components.push_back(component);
+            ++current->componentCount;
+        }
+    }
+}
+
+// Depth-first walk of the component graph in file order. An edge back to a
+// composite still on the walk's path closes a cycle: it is reported and
+// marked so it is never added, which leaves the catalog acyclic.
+size_t breakCycles(const FoodCatalog& catalog, const std::vector<Definition>& definitions,
+                   const std::vector<CompositeChunk>& chunks) {
+    const size_t MAX_REPORTED = 10;
+    enum : std::uint8_t { UNVISITED, ON_PATH, DONE };
+    struct Frame {
+        FoodHandle handle;
+        std::uint32_t next;
+    };
+
+    std::vector<std::uint8_t> state(definitions.size(), UNVISITED);
+    std::vector<Frame> path;
+    size_t cycles = 0;
+    for (const auto& chunk : chunks) {
+        for (const auto& record : chunk.records) {
+            if (state[record.handle] != UNVISITED || definitions[record.handle].record != &record) continue;
+            state[record.handle] = ON_PATH;
+            path.push_back({record.handle, 0});
+
+            while (!path.empty()) {
+                Frame& top = path.back();
+                const Definition& definition = definitions[top.handle];
+                if (top.next == definition.record->componentCount) {
+                    state[top.handle] = DONE;
+                    path.pop_back();
+                    continue;
+                }
+                std::uint32_t c = definition.record->componentOffset + top.next++;
+                FoodHandle food = definition.chunk->resolved[c];
+                if (food == INVALID_FOOD_HANDLE || food >= definitions.size() || !definitions[food].record) continue;
+
+                if (state[food] == ON_PATH) {
+                    definition.chunk->cyclic[c] = 1;
+                    if (++cycles <= MAX_REPORTED) {
+                        std::string cycle;
+                        for (size_t i = 0; i < path.size(); ++i) {
+                            if (!cycle.empty() || path[i].handle == food) {
+                                cycle += std::string(catalog.name(path[i].handle)) + " -> ";
+                            }
+                        }
+                        cycle += std::string(catalog.name(food));
+                        YADA_TRACE(WARNING, DATABASE, "Dropped component cycle " << cycle);
+                    }
+                } else if (state[food] == UNVISITED) {
+                    state[food] = ON_PATH;
+                    path.push_back({food, 0});
+                }
+            }
+        }
+    }
+    return cycles;
+}
+
+// Copies keyword views into reusable strings for the catalog
+const std::vector<std::string>& keywordStrings(const std::vector<std::string_view>& keywords,
+                                               std::uint32_t offset, std::uint32_t count,
+                                               std::vector<std::string>& scratch) {
+    scratch.resize(count);
+    for (std::uint32_t i = 0; i < count; ++i) {
+        scratch[i].assign(keywords[offset + i]);
+    }
+    return scratch;
+}
+
+} // namespace
+
+void FoodFileLoader::load(Database& database) {
+    Database::State& state = database.states[0];
+    utils::ThreadPool& pool = utils::ThreadPool::shared();
+    std::vector<std::string> scratch;
+    size_t malformed = 0;
+
+    utils::MappedFile basicFile(database.basicFoodsFile);
+    if (basicFile.isOpen()) {
+        auto pieces = splitChunks(basicFile.contents(), pool.concurrency() * 4, false);
+        std::vector<BasicChunk> chunks(pieces.size());
+        pool.parallelFor(pieces.size(), [&](size_t i) { parseBasicChunk(pieces[i], chunks[i]); });
+
+        for (const auto& chunk : chunks) {
+            for (const auto& record : chunk.records) {
+                state.defineBasicFood(std::string(record.id),
+                                      keywordStrings(chunk.keywords, record.keywordOffset, record.keywordCount, scratch),
+                                      record.calories);
+            }
+            malformed += chunk.malformed;
+        }
+        YADA_TRACE(INFO, DATABASE, "Loaded " << state.basicFoodCount << " basic foods in "
+                   << pieces.size() << " chunks");
+    } else {
+        YADA_TRACE(DETAIL, IO, "Could not open basic foods file: " << database.basicFoodsFile);
+    }
+
+    utils::MappedFile compositeFile(database.compositeFoodsFile);
+    if (compositeFile.isOpen()) {
+        auto pieces = splitChunks(compositeFile.contents(), pool.concurrency() * 4, true);
+        std::vector<CompositeChunk> chunks(pieces.size());
+        pool.parallelFor(pieces.size(), [&](size_t i) { parseCompositeChunk(pieces[i], chunks[i]); });
+
+        // First pass: define every composite so components can refer forward
+        std::vector<Definition> definitions;
+        for (auto& chunk : chunks) {
+            for (auto& record : chunk.records) {
+                record.handle = state.defineCompositeFood(
+                    std::string(record.id),
+                    keywordStrings(chunk.keywords, record.keywordOffset, record.keywordCount, scratch));
+                if (definitions.size() <= record.handle) definitions.resize(state.catalog.size());
+                definitions[record.handle] = {&chunk, &record};
+            }
+            malformed += chunk.malformed;
+        }
+
+        // Second pass: name lookups only read the catalog, so chunks resolve in parallel
+        pool.parallelFor(chunks.size(), [&](size_t i) {
+            auto& chunk = chunks[i];
+            chunk.resolved.resize(chunk.components.size());
+            chunk.cyclic.assign(chunk.components.size(), 0);
+            for (size_t c = 0; c < chunk.components.size(); ++c) {
+                chunk.resolved[c] = state.findFood(chunk.components[c].food);
+            }
+        });
+        size_t cycles = breakCycles(state.catalog, definitions, chunks);
+
+        size_t unresolved = 0;
+        for (const auto& chunk : chunks) {
+            for (const auto& record : chunk.records) {
+                if (definitions[record.handle].record != &record) continue;
+                for (std::uint32_t c = record.componentOffset; c < record.componentOffset + record.componentCount; ++c) {
+                    FoodHandle food = chunk.resolved[c];
+                    if (food == INVALID_FOOD_HANDLE) {
+                        ++unresolved;
+                        continue;
+                    }
+                    if (chunk.cyclic[c]) continue;
+                    state.catalog.addComponent(record.handle, food, chunk.components[c].servings);
+                }
+            }
+        }
+
+        // The graph is acyclic now; calories resolve level by level in dependency order
+        state.catalog.view();
+        YADA_TRACE(INFO, DATABASE, "Loaded " << state.compositeFoodCount << " composite foods in "
+                   << pieces.size() << " chunks");
+        if (unresolved > 0) {
+            YADA_TRACE(WARNING, DATABASE, "Skipped " << unresolved << " composite components naming unknown foods");
+        }
+        if (cycles > 0) {
+            YADA_TRACE(WARNING, DATABASE, "Dropped " << cycles << " composite components that formed cycles");
+        }
+    } else {
+        YADA_TRACE(DETAIL, IO, "Could not open composite foods file: " << database.compositeFoodsFile);
+    }
+
+    if (malformed > 0) {
+        YADA_TRACE(WARNING, IO, "Skipped " << malformed << " malformed lines in the food files");
+    }
+}
@@ -0,0 +1,156 @@
+#include "database/keyword_trie.h"
+#include <algorithm>
+
+KeywordTrie::KeywordTrie() {
+    clear();
+}
+
+void KeywordTrie::clear() {
+    firstChild.assign(1, NONE);
+    nextSibling.assign(1, NONE);
+    labels.assign(1, '\0');
+    wordEnds.assign(1, 0);
+    wordCount = 0;
+    erasedCount = 0;
+}
+
+size_t KeywordTrie::size() const {
+    return wordCount;
+}
+
+bool KeywordTrie::sparse() const {
+    return erasedCount > wordCount + 64;
+}
+
+std::uint32_t KeywordTrie::child(std::uint32_t node, char label) const {
+    for (std::uint32_t next = firstChild[node]; next != NONE; next = nextSibling[next]) {
+        if (labels[next] == label) return next;
+        if (static_cast<unsigned char>(labels[next]) > static_cast<unsigned char>(label)) break;
+    }
+    return NONE;
+}
+
+std::uint32_t KeywordTrie::find(std::string_view word) const {
+    std::uint32_t node = 0;
+    for (char c : word) {
+        node = child(node, c);
+        if (node == NONE) return NONE;
+    }
+    return node;
+}
+
+void KeywordTrie::insert(std::string_view word) {
+    std::uint32_t node = 0;
+    for (char c : word) {
+        // Find the child or the sibling link it belongs after
+        std::uint32_t* link = &firstChild[node];
+        while (*link != NONE && static_cast<unsigned char>(labels[*link]) < static_cast<unsigned char>(c)) {
+            link = &nextSibling[*link];
+        }
+        if (*link == NONE || labels[*link] != c) {
+            std::uint32_t added = static_cast<std::uint32_t>(labels.size());
+            std::uint32_t after = *link;
+            // Growing the arrays would invalidate `link`, so it is written last
+            firstChild.push_back(NONE);
+            nextSibling.push_back(after);
+            labels.push_back(c);
+            wordEnds.push_back(0);
+            std::uint32_t previous = firstChild[node];
+            if (previous == after) {
+                firstChild[node] = added;
+            } else {
+                while (nextSibling[previous] != after) previous = nextSibling[previous];
+                nextSibling[previous] = added;
+            }
+            node = added;
+        } else {
+            node = *link;
+        }
+    }
+    if (!wordEnds[node]) {
+        wordEnds[node] = 1;
+        ++wordCount;
+    }
+}
+
+void KeywordTrie::erase(std::string_view word) {
+    std::uint32_t node = find(word);
+    if ((node != NONE || word.empty()) && wordEnds[node]) {
+        wordEnds[node] = 0;
+        --wordCount;
+        ++erasedCount;
+    }
+}
+
+void KeywordTrie::forEachWithPrefix(std::string_view prefix, const Visitor& visit) const {
+    std::uint32_t start = find(prefix);
+    if (start == NONE && !prefix.empty()) return;
+
+    // Depth-first in label order; `path` holds the word spelled so far
+    std::string path(prefix);
+    std::vector<std::uint32_t> stack = {start};
+    std::vector<size_t> depths = {path.size()};
+    while (!stack.empty()) {
+        std::uint32_t node = stack.back();
+        size_t depth = depths.back();
+        stack.pop_back();
+        depths.pop_back();
+        path.resize(depth);
+        if (node != start) path += labels[node];
+        if (wordEnds[node]) visit(path);
+
+        // Pushed in reverse so the smallest label is visited first
+        size_t mark = stack.size();
+        for (std::uint32_t next = firstChild[node]; next != NONE; next = nextSibling[next]) {
+            stack.push_back(next);
+            depths.push_back(path.size());
+        }
+        std::reverse(stack.begin() + mark, stack.end());
+    }
+}
+
+void KeywordTrie::forEachWithin(std::string_view word, int maxEdits, const Visitor& visit) const {
+    // rows[d] is the edit-distance row after spelling the first d trie labels:
+    // rows[d][i] = distance between that spelling and word[0, i)
+    const size_t width = word.size() + 1;
+    std::vector<int> rows(width);
+    for (size_t i = 0; i < width; ++i) rows[i] = static_cast<int>(i);
+    if (wordEnds[0] && rows[width - 1] <= maxEdits) visit(std::string_view());
+
+    std::string path;
+    std::vector<std::uint32_t> stack;
+    std::vector<size_t> depths;
+    for (std::uint32_t next = firstChild[0]; next != NONE; next = nextSibling[next]) {
+        stack.push_back(next);
+        depths.push_back(0);
+    }
+    std::reverse(stack.begin(), stack.end());
+    while (!stack.empty()) {
+        std::uint32_t node = stack.back();
+        size_t depth = depths.back();
+        stack.pop_back();
+        depths.pop_back();
+        path.resize(depth);
+        path += labels[node];
+
+        rows.resize((depth + 2) * width);
+        const int* above = rows.data() + depth * width;
+        int* row = rows.data() + (depth + 1) * width;
+        row[0] = above[0] + 1;
+        int best = row[0];
+        for (size_t i = 1; i < width; ++i) {
+            int substitute = above[i - 1] + (word[i - 1] == labels[node] ? 0 : 1);
+            row[i] = std::min({row[i - 1] + 1, above[i] + 1, substitute});
+            best = std::min(best, row[i]);
+        }
+        if (wordEnds[node] && row[width - 1] <= maxEdits) visit(path);
+        if (best > maxEdits) continue;
+
+        size_t mark = stack.size();
+        for (std::uint32_t next = firstChild[node]; next != NONE; next = nextSibling[next]) {
+            stack.push_back(next);
+            depths.push_back(depth + 1);
+        }
+        std::reverse(stack.begin() + mark, stack.end());
+    }
+}
@@ -0,0 +1,325 @@
+#include "database/snapshot.h"
+#include "database/database.h"
+#include "utils/binary_io.h"
+#include "utils/trace.h"
+#include <cstring>
+#include <filesystem>
+#include <system_error>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+const char SNAPSHOT_MAGIC[8] = {'Y', 'A', 'D', 'A', 'S', 'N', 'A', 'P'};
+
+struct FileStamp {
+    std::int64_t mtime;
+    std::int64_t size;  // -1 when the file does not exist
+};
+
+struct SnapshotHeader {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t foodCount;
+    FileStamp basicFoods;
+    FileStamp compositeFoods;
+    std::uint64_t payloadSize;
+    std::uint64_t checksum;
+    std::uint64_t nameArenaSize;
+    std::uint64_t keywordTableSize;
+    std::uint64_t keywordArenaSize;
+    std::uint64_t keywordCount;
+    std::uint64_t componentCount;
+    std::uint64_t indexEntryCount;
+    std::uint64_t postingCount;
+};
+
+// Fixed-width per-food record
+struct FoodRecord {
+    double calories;
+    std::uint32_t keywordOffset;
+    std::uint32_t keywordCount;
+    std::uint32_t componentOffset;
+    std::uint32_t componentCount;
+    std::uint8_t kind;
+    std::uint8_t padding[7];
+};
+
+struct IndexEntry {
+    KeywordId keyword;
+    std::uint32_t postingOffset;
+    std::uint32_t postingCount;
+    std::uint32_t kind;
+};
+
+FileStamp stampFile(const std::string& path) {
+    std::error_code ec;
+    auto size = std::filesystem::file_size(path, ec);
+    if (ec) return {0, -1};
+    auto mtime = std::filesystem::last_write_time(path, ec);
+    if (ec) return {0, -1};
+    return {static_cast<std::int64_t>(mtime.time_since_epoch().count()), static_cast<std::int64_t>(size)};
+}
+
+bool sameStamp(const FileStamp& a, const FileStamp& b) {
+    return a.mtime == b.mtime && a.size == b.size;
+}
+
+} // namespace
+
+bool CatalogSnapshot::write(const std::string& path, const Database& database) {
+    const Database::State& state = *database.published.load();
+    const FoodCatalog& catalog = state.catalog;
+    utils::PayloadWriter payload;
+    SnapshotHeader header = {};
+    std::memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = VERSION;
+    header.foodCount = static_cast<std::uint32_t>(catalog.size());
+    header.basicFoods = stampFile(database.basicFoodsFile);
+    header.compositeFoods = stampFile(database.compositeFoodsFile);
+
+    // String table for names
+    header.nameArenaSize = catalog.nameArena.size();
+    payload.putBytes(reinterpret_cast<const char*>(catalog.nameOffsets.data()),
+                     catalog.nameOffsets.size() * sizeof(std::uint32_t));
+    payload.putBytes(catalog.nameArena.data(), catalog.nameArena.size());
+    payload.align();
+
+    // String table for keywords; the ids are kept, so spans and index entries refer to them
+    header.keywordTableSize = catalog.keywordTableSize();
+    header.keywordArenaSize = catalog.keywordArena.size();
+    payload.putArray(catalog.keywordTextOffsets);
+    payload.putBytes(catalog.keywordArena.data(), catalog.keywordArena.size());
+    payload.align();
+
+    // Food records, with keyword and component spans compacted as they are written
+    std::vector<KeywordId> keywords;
+    std::vector<FoodComponent> components;
+    for (FoodHandle handle = 0; handle < catalog.size(); ++handle) {
+        FoodRecord record = {};
+        record.calories = catalog.caloriesPerServing(handle);
+        record.kind = static_cast<std::uint8_t>(catalog.kind(handle));
+        record.keywordOffset = static_cast<std::uint32_t>(keywords.size());
+        for (KeywordId keyword : catalog.keywords(handle)) {
+            keywords.push_back(keyword);
+        }
+        record.keywordCount = static_cast<std::uint32_t>(keywords.size()) - record.keywordOffset;
+        record.componentOffset = static_cast<std::uint32_t>(components.size());
+        for (const auto& component : catalog.components(handle)) {
+            components.push_back(component);
+        }
+        record.componentCount = static_cast<std::uint32_t>(components.size()) - record.componentOffset;
+        payload.put(record);
+    }
+
+    header.keywordCount = keywords.size();
+    payload.putArray(keywords);
+    payload.align();
+
+    header.componentCount = components.size();
+    payload.putBytes(reinterpret_cast<const char*>(components.data()), components.size() * sizeof(FoodComponent));
+    payload.align();
+
+    // Prebuilt keyword index, one entry per non-empty posting list
+    std::vector<IndexEntry> entries;
+    std::vector<FoodHandle> postings;
+    auto appendIndex = [&](const Database::KeywordIndex& index, FoodKind kind) {
+        for (KeywordId keyword = 0; keyword < index.size(); ++keyword) {
+            const auto& list = index[keyword];
+            if (list.empty()) continue;
+            IndexEntry entry = {};
+            entry.keyword = keyword;
+            entry.postingOffset = static_cast<std::uint32_t>(postings.size());
+            entry.postingCount = static_cast<std::uint32_t>(list.size());
+            entry.kind = static_cast<std::uint32_t>(kind);
+            postings.insert(postings.end(), list.begin(), list.end());
+            entries.push_back(entry);
+        }
+    };
+    appendIndex(state.basicKeywordIndex, FoodKind::BASIC);
+    appendIndex(state.compositeKeywordIndex, FoodKind::COMPOSITE);
+
+    header.indexEntryCount = entries.size();
+    header.postingCount = postings.size();
+    payload.putBytes(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(IndexEntry));
+    payload.putBytes(reinterpret_cast<const char*>(postings.data()), postings.size() * sizeof(FoodHandle));
+    payload.align();
+
+    // Vocabulary tries, node arrays as they are, so loading skips the rebuild
+    auto appendTrie = [&](const KeywordTrie& trie) {
+        payload.put(static_cast<std::uint64_t>(trie.labels.size()));
+        payload.put(static_cast<std::uint64_t>(trie.wordCount));
+        payload.put(static_cast<std::uint64_t>(trie.erasedCount));
+        payload.putArray(trie.firstChild);
+        payload.putArray(trie.nextSibling);
+        payload.putArray(trie.labels);
+        payload.putArray(trie.wordEnds);
+        payload.align();
+    };
+    appendTrie(state.basicVocabulary);
+    appendTrie(state.compositeVocabulary);
+
+    header.payloadSize = payload.data().size();
+    header.checksum = utils::checksum64(payload.data().data(), payload.data().size());
+
+    // Written to a temporary file and renamed so a crash never leaves a torn snapshot
+    if (!utils::replaceFile(path, &header, sizeof(header), payload.data())) {
+        YADA_TRACE(WARNING, IO, "Could not write snapshot file: " << path);
+        return false;
+    }
+    YADA_TRACE(INFO, IO, "Wrote catalog snapshot with " << header.foodCount << " foods to " << path);
+    return true;
+}
+
+bool CatalogSnapshot::load(const std::string& path, Database& database) {
+#ifdef _WIN32
+    (void)path;
+    (void)database;
+    return false;
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    struct stat info;
+    if (::fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(SnapshotHeader)) {
+        ::close(fd);
+        return false;
+    }
+    size_t mappedSize = static_cast<size_t>(info.st_size);
+    void* mapping = ::mmap(nullptr, mappedSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) return false;
+
+    const char* base = static_cast<const char*>(mapping);
+    SnapshotHeader header;
+    std::memcpy(&header, base, sizeof(header));
+    const char* payload = base + sizeof(header);
+
+    bool fresh = std::memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) == 0
+        && header.version == VERSION
+        && header.payloadSize == mappedSize - sizeof(header)
+        && sameStamp(header.basicFoods, stampFile(database.basicFoodsFile))
+        && sameStamp(header.compositeFoods, stampFile(database.compositeFoodsFile))
+        && utils::checksum64(payload, header.payloadSize) == header.checksum;
+    if (!fresh) {
+        ::munmap(mapping, mappedSize);
+        YADA_TRACE(INFO, IO, "Catalog snapshot is missing, stale or corrupt: " << path);
+        return false;
+    }
+
+    FoodCatalog catalog;
+    utils::PayloadReader reader(payload, header.payloadSize);
+    bool ok = utils::copyArray(reader, catalog.nameOffsets, size_t(header.foodCount) + 1);
+    const char* names = reader.take(header.nameArenaSize);
+    ok = ok && names;
+    if (ok) catalog.nameArena.assign(names, header.nameArenaSize);
+    reader.align(payload);
+
+    ok = ok && utils::copyArray(reader, catalog.keywordTextOffsets, header.keywordTableSize + 1);
+    const char* keywordText = reader.take(header.keywordArenaSize);
+    ok = ok && keywordText;
+    if (ok) catalog.keywordArena.assign(keywordText, header.keywordArenaSize);
+    reader.align(payload);
+
+    const char* records = reader.take(size_t(header.foodCount) * sizeof(FoodRecord));
+    ok = ok && records && utils::copyArray(reader, catalog.keywordPool, header.keywordCount);
+    reader.align(payload);
+    ok = ok && utils::copyArray(reader, catalog.componentPool, header.componentCount);
+    reader.align(payload);
+    const char* entries = reader.take(header.indexEntryCount * sizeof(IndexEntry));
+    const char* postings = reader.take(header.postingCount * sizeof(FoodHandle));
+    ok = ok && entries && postings;
+    reader.align(payload);
+    auto readTrie = [&](KeywordTrie& trie) {
+        const char* counts = reader.take(3 * sizeof(std::uint64_t));
+        if (!counts) return false;
+        std::uint64_t nodes, words, erased;
+        std::memcpy(&nodes, counts, sizeof(nodes));
+        std::memcpy(&words, counts + sizeof(nodes), sizeof(words));
+        std::memcpy(&erased, counts + 2 * sizeof(nodes), sizeof(erased));
+        trie.wordCount = words;
+        trie.erasedCount = erased;
+        bool read = nodes > 0 && utils::copyArray(reader, trie.firstChild, nodes)
+            && utils::copyArray(reader, trie.nextSibling, nodes) && utils::copyArray(reader, trie.labels, nodes)
+            && utils::copyArray(reader, trie.wordEnds, nodes);
+        reader.align(payload);
+        return read;
+    };
+    KeywordTrie basicVocabulary;
+    KeywordTrie compositeVocabulary;
+    ok = ok && readTrie(basicVocabulary) && readTrie(compositeVocabulary);
+    if (!ok) {
+        ::munmap(mapping, mappedSize);
+        return false;
+    }
+
+    // Column arrays are sized once; nothing is built per keyword
+    size_t foodCount = header.foodCount;
+    catalog.kinds.resize(foodCount);
+    catalog.calories.resize(foodCount);
+    catalog.caloriesValid.assign(foodCount, 1);
+    catalog.keywordOffsets.resize(foodCount);
+    catalog.keywordCounts.resize(foodCount);
+    catalog.keywordSignatures.assign(foodCount, 0);
+    catalog.componentOffsets.resize(foodCount);
+    catalog.componentCounts.resize(foodCount);
+    catalog.dependents.resize(foodCount);
+    size_t basicCount = 0;
+    size_t compositeCount = 0;
+    for (size_t h = 0; h < foodCount; ++h) {
+        FoodRecord record;
+        std::memcpy(&record, records + h * sizeof(FoodRecord), sizeof(record));
+        catalog.kinds[h] = static_cast<FoodKind>(record.kind);
+        catalog.calories[h] = record.calories;
+        catalog.keywordOffsets[h] = record.keywordOffset;
+        catalog.keywordCounts[h] = record.keywordCount;
+        catalog.componentOffsets[h] = record.componentOffset;
+        catalog.componentCounts[h] = record.componentCount;
+        if (catalog.kinds[h] == FoodKind::BASIC) ++basicCount;
+        if (catalog.kinds[h] == FoodKind::COMPOSITE) ++compositeCount;
+    }
+    for (FoodHandle h = 0; h < foodCount; ++h) {
+        for (KeywordId keyword : catalog.keywords(h)) {
+            catalog.keywordSignatures[h] |= FoodCatalog::keywordSignature(keyword);
+        }
+        for (const auto& component : catalog.components(h)) {
+            catalog.dependents[component.food].push_back(h);
+        }
+    }
+    size_t slotCount = 16;
+    while (slotCount < foodCount * 2) slotCount *= 2;
+    catalog.rehash(slotCount);
+    size_t keywordTableSize = header.keywordTableSize;
+    slotCount = 16;
+    while (slotCount < keywordTableSize * 2) slotCount *= 2;
+    catalog.rehashKeywords(slotCount);
+
+    Database::KeywordIndex basicIndex(keywordTableSize);
+    Database::KeywordIndex compositeIndex(keywordTableSize);
+    for (size_t i = 0; i < header.indexEntryCount; ++i) {
+        IndexEntry entry;
+        std::memcpy(&entry, entries + i * sizeof(IndexEntry), sizeof(entry));
+        auto& index = static_cast<FoodKind>(entry.kind) == FoodKind::BASIC ? basicIndex : compositeIndex;
+        auto& list = index[entry.keyword];
+        list.resize(entry.postingCount);
+        std::memcpy(list.data(), postings + size_t(entry.postingOffset) * sizeof(FoodHandle),
+                    entry.postingCount * sizeof(FoodHandle));
+    }
+    ::munmap(mapping, mappedSize);
+
+    // Only called before the database publishes anything, so the first copy is free to replace
+    Database::State& state = database.states[0];
+    state.catalog = std::move(catalog);
+    state.basicKeywordIndex = std::move(basicIndex);
+    state.compositeKeywordIndex = std::move(compositeIndex);
+    state.basicVocabulary = std::move(basicVocabulary);
+    state.compositeVocabulary = std::move(compositeVocabulary);
+    state.basicFoodCount = basicCount;
+    state.compositeFoodCount = compositeCount;
+    YADA_TRACE(INFO, IO, "Loaded " << foodCount << " foods from catalog snapshot " << path);
+    return true;
+#endif
+}
@@ -1,16 +1,19 @@
 #include "food/basic_food.h"
+#include "database/database.h"
+#include "utils/trace.h"
 #include <sstream>
-#include <iostream>
 
-BasicFood::BasicFood(const std::string& id, const std::vector<std::string>& keys, double calories)
-    : Food(id, keys, calories) {
-    #ifdef DEBUG
-    std::cout << "DEBUG: Created BasicFood object with ID: " << id << std::endl;
-    #endif
+BasicFood::BasicFood(Database& database, FoodHandle handle)
+    : Food(database, handle) {
+    YADA_TRACE(VERBOSE, DATABASE, "Created BasicFood object with handle: " << handle);
+}
+
+void BasicFood::setCaloriesPerServing(double calories) {
+    database->setCalories(handle, calories);
 }
 
 double BasicFood::calculateCalories(int servings) const {
-    return caloriesPerServing * servings;
+    return getCaloriesPerServing() * servings;
 }
 
 bool BasicFood::isComposite() const {
@@ -18,19 +21,19 @@ bool BasicFood::isComposite() const {
 }
 
 std::string BasicFood::toString() const {
+    auto reader = database->read();
+    const FoodCatalog& catalog = reader.catalog();
     std::stringstream ss;
-    ss << "Basic Food: " << identifier << "\n";
+    ss << "Basic Food: " << catalog.name(handle) << "\n";
     ss << "Keywords: ";
-    for (const auto& keyword : keywords) {
-        ss << keyword << " ";
+    for (KeywordId keyword : catalog.keywords(handle)) {
+        ss << catalog.keywordText(keyword) << " ";
     }
-    ss << "\nCalories per serving: " << caloriesPerServing;
+    ss << "\nCalories per serving: " << catalog.caloriesPerServing(handle);
     return ss.str();
 }
 
-#ifdef DEBUG
-void BasicFood::debugPrint() const {
-    std::cout << "DEBUG: BasicFood Object:" << std::endl;
-    Food::debugPrint();
+void BasicFood::debugPrint(std::ostream& out) const {
+    out << "BasicFood Object:\n";
+    Food::debugPrint(out);
 }
-#endif 
\ No newline at end of file
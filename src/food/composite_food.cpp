@@ -1,46 +1,43 @@
 #include "food/composite_food.h"
+#include "database/database.h"
+#include "utils/trace.h"
 #include <sstream>
-#include <iostream>
 
-CompositeFood::CompositeFood(const std::string& id, const std::vector<std::string>& keys)
-    : Food(id, keys, 0.0) {
-    #ifdef DEBUG
-    std::cout << "DEBUG: Created CompositeFood object with ID: " << id << std::endl;
-    #endif
+CompositeFood::CompositeFood(Database& database, FoodHandle handle)
+    : Food(database, handle) {
+    YADA_TRACE(VERBOSE, DATABASE, "Created CompositeFood object with handle: " << handle);
 }
 
-void CompositeFood::addComponent(std::shared_ptr<Food> food, int servings) {
-    components[food->getIdentifier()] = {food, servings};
-    // Recalculate calories per serving
-    caloriesPerServing = calculateCalories(1);
-    #ifdef DEBUG
-    std::cout << "DEBUG: Added component " << food->getIdentifier() 
-              << " with " << servings << " servings to composite food " 
-              << identifier << std::endl;
-    #endif
+bool CompositeFood::addComponent(const Food& food, int servings) {
+    if (!database->addComponent(handle, food.getHandle(), servings)) {
+        YADA_TRACE(DETAIL, DATABASE, "Refused component " << food.getIdentifier() << " for composite food "
+                   << getIdentifier());
+        return false;
+    }
+    YADA_TRACE(DETAIL, DATABASE, "Added component " << food.getIdentifier() << " with " << servings
+               << " servings to composite food " << getIdentifier());
+    return true;
 }
 
 void CompositeFood::removeComponent(const std::string& foodId) {
-    components.erase(foodId);
-    // Recalculate calories per serving
-    caloriesPerServing = calculateCalories(1);
-    #ifdef DEBUG
-    std::cout << "DEBUG: Removed component " << foodId 
-              << " from composite food " << identifier << std::endl;
-    #endif
+    FoodHandle food = database->findFood(foodId);
+    if (food == INVALID_FOOD_HANDLE) return;
+    database->removeComponent(handle, food);
+    YADA_TRACE(DETAIL, DATABASE, "Removed component " << foodId << " from composite food " << getIdentifier());
 }
 
-const std::map<std::string, std::pair<std::shared_ptr<Food>, int>>& 
-CompositeFood::getComponents() const {
-    return components;
+void CompositeFood::clearComponents() {
+    database->clearComponents(handle);
+}
+
+std::vector<FoodComponent> CompositeFood::getComponents() const {
+    auto reader = database->read();
+    auto components = reader.catalog().components(handle);
+    return std::vector<FoodComponent>(components.begin(), components.end());
 }
 
 double CompositeFood::calculateCalories(int servings) const {
-    double totalCalories = 0.0;
-    for (const auto& component : components) {
-        totalCalories += component.second.first->calculateCalories(component.second.second);
-    }
-    return totalCalories * servings;
+    return getCaloriesPerServing() * servings;
 }
 
 bool CompositeFood::isComposite() const {
@@ -48,29 +45,31 @@ bool CompositeFood::isComposite() const {
 }
 
 std::string CompositeFood::toString() const {
+    auto reader = database->read();
+    const FoodCatalog& catalog = reader.catalog();
     std::stringstream ss;
-    ss << "Composite Food: " << identifier << "\n";
+    ss << "Composite Food: " << catalog.name(handle) << "\n";
     ss << "Keywords: ";
-    for (const auto& keyword : keywords) {
-        ss << keyword << " ";
+    for (KeywordId keyword : catalog.keywords(handle)) {
+        ss << catalog.keywordText(keyword) << " ";
     }
     ss << "\nComponents:\n";
-    for (const auto& component : components) {
-        ss << "  - " << component.first << " (" 
-           << component.second.second << " servings)\n";
+    for (const auto& component : catalog.components(handle)) {
+        ss << "  - " << catalog.name(component.food) << " ("
+           << component.servings << " servings)\n";
     }
-    ss << "Total calories per serving: " << caloriesPerServing;
+    ss << "Total calories per serving: " << catalog.caloriesPerServing(handle);
     return ss.str();
 }
 
-#ifdef DEBUG
-void CompositeFood::debugPrint() const {
-    std::cout << "DEBUG: CompositeFood Object:" << std::endl;
-    Food::debugPrint();
-    std::cout << "  Components:" << std::endl;
-    for (const auto& component : components) {
-        std::cout << "    - " << component.first 
-                  << " (" << component.second.second << " servings)" << std::endl;
+void CompositeFood::debugPrint(std::ostream& out) const {
+    out << "CompositeFood Object:\n";
+    Food::debugPrint(out);
+    auto reader = database->read();
+    const FoodCatalog& catalog = reader.catalog();
+    out << "  Components:\n";
+    for (const auto& component : catalog.components(handle)) {
+        out << "    - " << catalog.name(component.food)
+            << " (" << component.servings << " servings)\n";
     }
 }
-#endif 
\ No newline at end of file
@@ -1,34 +1,47 @@
 #include "food/food.h"
-#include <iostream>
+#include "database/database.h"
+#include "utils/trace.h"
 
-Food::Food(const std::string& id, const std::vector<std::string>& keys, double calories)
-    : identifier(id), keywords(keys), caloriesPerServing(calories) {
-    #ifdef DEBUG
-    std::cout << "DEBUG: Created Food object with ID: " << id << std::endl;
-    #endif
+Food::Food(Database& database, FoodHandle handle)
+    : database(&database), handle(handle) {
+    YADA_TRACE(VERBOSE, DATABASE, "Created Food object with handle: " << handle);
+}
+
+FoodHandle Food::getHandle() const {
+    return handle;
 }
 
 std::string Food::getIdentifier() const {
-    return identifier;
+    return std::string(database->read().catalog().name(handle));
 }
 
 std::vector<std::string> Food::getKeywords() const {
+    auto reader = database->read();
+    const FoodCatalog& catalog = reader.catalog();
+    std::vector<std::string> keywords;
+    for (KeywordId keyword : catalog.keywords(handle)) {
+        keywords.emplace_back(catalog.keywordText(keyword));
+    }
     return keywords;
 }
 
 double Food::getCaloriesPerServing() const {
-    return caloriesPerServing;
+    return database->read().view().caloriesPerServing(handle);
+}
+
+void Food::setKeywords(const std::vector<std::string>& keys) {
+    database->setKeywords(handle, keys);
 }
 
-#ifdef DEBUG
-void Food::debugPrint() const {
-    std::cout << "DEBUG: Food Object:" << std::endl;
-    std::cout << "  ID: " << identifier << std::endl;
-    std::cout << "  Keywords: ";
-    for (const auto& keyword : keywords) {
-        std::cout << keyword << " ";
+void Food::debugPrint(std::ostream& out) const {
+    auto reader = database->read();
+    const FoodCatalog& catalog = reader.catalog();
+    out << "Food Object:\n";
+    out << "  ID: " << catalog.name(handle) << "\n";
+    out << "  Keywords: ";
+    for (KeywordId keyword : catalog.keywords(handle)) {
+        out << catalog.keywordText(keyword) << " ";
     }
-    std::cout << std::endl;
-    std::cout << "  Calories per serving: " << caloriesPerServing << std::endl;
+    out << "\n";
+    out << "  Calories per serving: " << catalog.caloriesPerServing(handle) << "\n";
 }
-#endif 
\ No newline at end of file
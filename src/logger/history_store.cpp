@@ -0,0 +1,446 @@
+#include "logger/history_store.h"
+#include "database/database.h"
+#include "utils/binary_io.h"
+#include "utils/calorie_kernel.h"
+#include "utils/field_reader.h"
+#include "utils/mapped_file.h"
+#include "utils/trace.h"
+#include "utils/utils.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <system_error>
+#include <unordered_map>
+
+namespace {
+
+const char SEGMENT_MAGIC[8] = {'Y', 'A', 'D', 'A', 'H', 'I', 'S', 'T'};
+
+struct SegmentHeader {
+    char magic[8];
+    std::uint32_t version;
+    std::int32_t year;
+    std::int32_t firstDay;
+    std::uint32_t dayCount;
+    std::uint64_t rowCount;
+    std::uint64_t foodCount;
+    std::uint64_t nameArenaSize;
+    std::uint64_t payloadSize;
+    std::uint64_t checksum;
+};
+
+int yearOf(int day) {
+    return std::stoi(utils::fromDayNumber(day).substr(0, 4));
+}
+
+int yearStart(int year) {
+    return utils::toDayNumber(std::to_string(year) + "-01-01");
+}
+
+HistorySegment emptySegment(int year) {
+    HistorySegment segment;
+    segment.year = year;
+    segment.firstDay = yearStart(year);
+    segment.dayOffsets.assign(yearStart(year + 1) - segment.firstDay + 1, 0);
+    return segment;
+}
+
+void appendRow(HistorySegment& segment, int day, FoodHandle food, int servings, std::int64_t timestamp) {
+    segment.days.push_back(day);
+    segment.foods.push_back(food);
+    segment.servings.push_back(servings);
+    segment.timestamps.push_back(timestamp);
+}
+
+// Offsets must be non-decreasing and end exactly at `total`
+bool validOffsets(const std::vector<std::uint32_t>& offsets, std::uint64_t total) {
+    for (size_t i = 1; i < offsets.size(); ++i) {
+        if (offsets[i] < offsets[i - 1]) return false;
+    }
+    return !offsets.empty() && offsets.front() == 0 && offsets.back() == total;
+}
+
+} // namespace
+
+int HistorySegment::dayCount() const {
+    return static_cast<int>(dayOffsets.size()) - 1;
+}
+
+size_t HistorySegment::rowCount() const {
+    return foods.size();
+}
+
+HistoryStore::HistoryStore(const std::string& directory, Database& database)
+    : directory(directory), database(database) {}
+
+std::string HistoryStore::segmentPath(int year) const {
+    return directory + "/" + std::to_string(year) + ".seg";
+}
+
+HistorySegment& HistoryStore::segment(int year) {
+    auto cached = segments.find(year);
+    if (cached != segments.end()) {
+        segmentOrder.remove(year);
+        segmentOrder.push_front(year);
+        return cached->second;
+    }
+
+    HistorySegment loaded;
+    if (!readSegment(year, loaded)) {
+        loaded = emptySegment(year);
+    }
+    while (segments.size() >= MAX_CACHED_SEGMENTS) {
+        segments.erase(segmentOrder.back());
+        segmentOrder.pop_back();
+    }
+    segmentOrder.push_front(year);
+    return segments.emplace(year, std::move(loaded)).first->second;
+}
+
+bool HistoryStore::readSegment(int year, HistorySegment& segment) {
+    std::string path = segmentPath(year);
+    utils::MappedFile file(path);
+    if (!file.isOpen()) return false;
+
+    std::string_view contents = file.contents();
+    SegmentHeader header;
+    const char* payload = contents.data() + sizeof(header);
+    bool valid = contents.size() >= sizeof(header);
+    if (valid) {
+        std::memcpy(&header, contents.data(), sizeof(header));
+        HistorySegment expected = emptySegment(year);
+        valid = std::memcmp(header.magic, SEGMENT_MAGIC, sizeof(header.magic)) == 0
+            && header.version == VERSION
+            && header.year == year
+            && header.firstDay == expected.firstDay
+            && static_cast<int>(header.dayCount) == expected.dayCount()
+            && header.payloadSize == contents.size() - sizeof(header)
+            && utils::checksum64(payload, header.payloadSize) == header.checksum;
+    }
+
+    // Foods are stored as indexes into the segment's own name table
+    std::vector<std::uint32_t> localFoods;
+    std::vector<std::uint32_t> nameOffsets;
+    const char* names = nullptr;
+    if (valid) {
+        utils::PayloadReader reader(payload, header.payloadSize);
+        valid = utils::copyArray(reader, segment.dayOffsets, size_t(header.dayCount) + 1);
+        reader.align(payload);
+        valid = valid && utils::copyArray(reader, segment.days, header.rowCount);
+        reader.align(payload);
+        valid = valid && utils::copyArray(reader, localFoods, header.rowCount);
+        reader.align(payload);
+        valid = valid && utils::copyArray(reader, segment.servings, header.rowCount);
+        reader.align(payload);
+        valid = valid && utils::copyArray(reader, segment.timestamps, header.rowCount);
+        valid = valid && utils::copyArray(reader, nameOffsets, header.foodCount + 1);
+        names = reader.take(header.nameArenaSize);
+        valid = valid && names && validOffsets(segment.dayOffsets, header.rowCount)
+            && validOffsets(nameOffsets, header.nameArenaSize)
+            && std::all_of(localFoods.begin(), localFoods.end(),
+                           [&](std::uint32_t food) { return food < header.foodCount; });
+    }
+    if (!valid) {
+        // Moved aside rather than overwritten by the next write of this year
+        std::error_code ec;
+        std::filesystem::rename(path, path + ".corrupt", ec);
+        YADA_TRACE(ERROR, IO, "History segment is corrupt and was moved aside: " << path);
+        return false;
+    }
+
+    std::vector<FoodHandle> handles(header.foodCount);
+    for (size_t food = 0; food < handles.size(); ++food) {
+        handles[food] = database.internFood(
+            std::string_view(names + nameOffsets[food], nameOffsets[food + 1] - nameOffsets[food]));
+    }
+    segment.foods.resize(localFoods.size());
+    for (size_t row = 0; row < localFoods.size(); ++row) {
+        segment.foods[row] = handles[localFoods[row]];
+    }
+    segment.year = year;
+    segment.firstDay = header.firstDay;
+    YADA_TRACE(DETAIL, IO, "Read " << segment.rowCount() << " log rows from " << path);
+    return true;
+}
+
+bool HistoryStore::writeSegment(const HistorySegment& segment, const std::string& path) const {
+    // Local food indexes in first-use order, and the names they stand for
+    std::unordered_map<FoodHandle, std::uint32_t> localIds;
+    std::vector<std::uint32_t> localFoods(segment.rowCount());
+    std::vector<std::uint32_t> nameOffsets(1, 0);
+    std::string names;
+    {
+        auto reader = database.read();
+        for (size_t row = 0; row < segment.rowCount(); ++row) {
+            auto [it, added] = localIds.emplace(segment.foods[row], static_cast<std::uint32_t>(localIds.size()));
+            if (added) {
+                names += reader.catalog().name(segment.foods[row]);
+                nameOffsets.push_back(static_cast<std::uint32_t>(names.size()));
+            }
+            localFoods[row] = it->second;
+        }
+    }
+
+    utils::PayloadWriter payload;
+    payload.putArray(segment.dayOffsets);
+    payload.align();
+    payload.putArray(segment.days);
+    payload.align();
+    payload.putArray(localFoods);
+    payload.align();
+    payload.putArray(segment.servings);
+    payload.align();
+    payload.putArray(segment.timestamps);
+    payload.putArray(nameOffsets);
+    payload.putBytes(names.data(), names.size());
+    payload.align();
+
+    SegmentHeader header = {};
+    std::memcpy(header.magic, SEGMENT_MAGIC, sizeof(header.magic));
+    header.version = VERSION;
+    header.year = segment.year;
+    header.firstDay = segment.firstDay;
+    header.dayCount = static_cast<std::uint32_t>(segment.dayCount());
+    header.rowCount = segment.rowCount();
+    header.foodCount = localIds.size();
+    header.nameArenaSize = names.size();
+    header.payloadSize = payload.data().size();
+    header.checksum = utils::checksum64(payload.data().data(), payload.data().size());
+    if (!utils::writeFile(path, &header, sizeof(header), payload.data())) {
+        YADA_TRACE(WARNING, IO, "Could not write history segment: " << path);
+        return false;
+    }
+    return true;
+}
+
+std::vector<LogEntry> HistoryStore::readDay(int day) {
+    const HistorySegment& stored = segment(yearOf(day));
+    size_t index = static_cast<size_t>(day - stored.firstDay);
+    std::vector<LogEntry> entries;
+    entries.reserve(stored.dayOffsets[index + 1] - stored.dayOffsets[index]);
+    for (std::uint32_t row = stored.dayOffsets[index]; row < stored.dayOffsets[index + 1]; ++row) {
+        entries.push_back({stored.foods[row], stored.servings[row], static_cast<std::time_t>(stored.timestamps[row])});
+    }
+    return entries;
+}
+
+bool HistoryStore::hasDay(int day) {
+    const HistorySegment& stored = segment(yearOf(day));
+    size_t index = static_cast<size_t>(day - stored.firstDay);
+    return stored.dayOffsets[index + 1] > stored.dayOffsets[index];
+}
+
+bool HistoryStore::writeDays(const std::map<int, std::vector<LogEntry>>& days) {
+    std::vector<HistorySegment> updated;
+    auto change = days.begin();
+    while (change != days.end()) {
+        int year = yearOf(change->first);
+        auto yearEnd = days.lower_bound(yearStart(year + 1));
+
+        // Rebuild the year's columns, taking replaced days from `days`
+        const HistorySegment& stored = segment(year);
+        HistorySegment& rebuilt = updated.emplace_back(emptySegment(year));
+        rebuilt.days.reserve(stored.rowCount());
+        rebuilt.foods.reserve(stored.rowCount());
+        rebuilt.servings.reserve(stored.rowCount());
+        rebuilt.timestamps.reserve(stored.rowCount());
+        for (int index = 0; index < stored.dayCount(); ++index) {
+            int day = stored.firstDay + index;
+            rebuilt.dayOffsets[index] = static_cast<std::uint32_t>(rebuilt.rowCount());
+            if (change != yearEnd && change->first == day) {
+                for (const auto& entry : change->second) {
+                    appendRow(rebuilt, day, entry.food, entry.servings, entry.timestamp);
+                }
+                ++change;
+            } else {
+                for (std::uint32_t row = stored.dayOffsets[index]; row < stored.dayOffsets[index + 1]; ++row) {
+                    appendRow(rebuilt, day, stored.foods[row], stored.servings[row], stored.timestamps[row]);
+                }
+            }
+        }
+        rebuilt.dayOffsets.back() = static_cast<std::uint32_t>(rebuilt.rowCount());
+        change = yearEnd;
+    }
+
+    // Every year is written aside before any replaces its file, so a failed
+    // write leaves the whole history as it was
+    std::error_code ec;
+    for (size_t i = 0; i < updated.size(); ++i) {
+        if (updated[i].rowCount() > 0 && !writeSegment(updated[i], segmentPath(updated[i].year) + ".tmp")) {
+            for (size_t written = 0; written < i; ++written) {
+                std::filesystem::remove(segmentPath(updated[written].year) + ".tmp", ec);
+            }
+            return false;
+        }
+    }
+    for (auto& rebuilt : updated) {
+        std::string path = segmentPath(rebuilt.year);
+        if (rebuilt.rowCount() > 0) {
+            std::filesystem::rename(path + ".tmp", path, ec);
+        } else {
+            std::filesystem::remove(path, ec);
+        }
+        YADA_TRACE(DETAIL, IO, "Wrote " << rebuilt.rowCount() << " log rows to " << path);
+
+        // Years evicted while later ones were rebuilt are simply read again
+        auto cached = segments.find(rebuilt.year);
+        if (cached != segments.end()) {
+            cached->second = std::move(rebuilt);
+        }
+    }
+    // The renames are only durable once the directory is synced
+    if (!updated.empty()) utils::syncDirectory(segmentPath(updated.front().year));
+    return true;
+}
+
+HistoryStore::Totals HistoryStore::total(int first, int last) {
+    Totals totals = {0.0, 0};
+    for (int year = yearOf(first); year <= yearOf(last); ++year) {
+        const HistorySegment& stored = segment(year);
+        size_t from = static_cast<size_t>(std::max(first, stored.firstDay) - stored.firstDay);
+        size_t to = static_cast<size_t>(std::min(last, stored.firstDay + stored.dayCount() - 1) - stored.firstDay);
+        for (size_t index = from; index <= to; ++index) {
+            totals.loggedDays += stored.dayOffsets[index + 1] > stored.dayOffsets[index];
+        }
+
+        // Loading may intern food names, so the catalog is pinned only now
+        auto reader = database.read();
+        std::uint32_t begin = stored.dayOffsets[from];
+        totals.calories += utils::sumCalories(reader.view().calorieTable(), stored.foods.data() + begin,
+                                              stored.servings.data() + begin, stored.dayOffsets[to + 1] - begin);
+    }
+    return totals;
+}
+
+std::vector<HistoryStore::Totals> HistoryStore::dailyTotals(int first, int last) {
+    std::vector<Totals> totals;
+    totals.reserve(last - first + 1);
+    std::vector<double> calories;
+    for (int year = yearOf(first); year <= yearOf(last); ++year) {
+        const HistorySegment& stored = segment(year);
+        size_t from = static_cast<size_t>(std::max(first, stored.firstDay) - stored.firstDay);
+        size_t to = static_cast<size_t>(std::min(last, stored.firstDay + stored.dayCount() - 1) - stored.firstDay);
+        calories.resize(to - from + 1);
+
+        auto reader = database.read();
+        utils::sumCaloriesByDay(reader.view().calorieTable(), stored.foods.data(), stored.servings.data(),
+                                stored.dayOffsets.data() + from, calories.size(), calories.data());
+        for (size_t index = from; index <= to; ++index) {
+            totals.push_back({calories[index - from], stored.dayOffsets[index + 1] > stored.dayOffsets[index] ? 1 : 0});
+        }
+    }
+    return totals;
+}
+
+void HistoryStore::clearCache() {
+    segments.clear();
+    segmentOrder.clear();
+}
+
+size_t HistoryStore::importDayFiles(const std::string& sourceDirectory, bool removeImported) {
+    size_t copied = 0;
+    copyDayFiles(sourceDirectory, removeImported, copied);
+    return copied;
+}
+
+bool HistoryStore::migrateDayFiles() {
+    size_t copied = 0;
+    return copyDayFiles(directory, true, copied);
+}
+
+bool HistoryStore::copyDayFiles(const std::string& sourceDirectory, bool removeImported, size_t& copied) {
+    std::map<int, std::vector<LogEntry>> days;
+    std::vector<std::pair<std::filesystem::path, size_t>> imported;
+    size_t malformed = 0;
+    std::error_code ec;
+    for (const auto& file : std::filesystem::directory_iterator(sourceDirectory, ec)) {
+        std::string date = file.path().stem().string();
+        if (file.path().extension() != ".log" || !utils::isCanonicalDate(date)) continue;
+
+        // foodId|servings|timestamp
+        utils::MappedFile contents(file.path().string());
+        if (!contents.isOpen()) continue;
+        std::vector<LogEntry>& entries = days[utils::toDayNumber(date)];
+        std::string_view text = contents.contents();
+        std::string_view line;
+        size_t skipped = 0;
+        while (utils::nextLine(text, line)) {
+            if (line.empty()) continue;
+            utils::FieldReader fields(line);
+            std::string_view food = fields.next('|');
+            LogEntry entry;
+            std::int64_t timestamp;
+            if (!utils::parseInt(fields.next('|'), entry.servings) || !utils::parseInt(fields.remainder(), timestamp)) {
+                ++skipped;
+                continue;
+            }
+            entry.food = database.internFood(food);
+            entry.timestamp = static_cast<std::time_t>(timestamp);
+            entries.push_back(entry);
+        }
+        malformed += skipped;
+        imported.emplace_back(file.path(), skipped);
+    }
+    if (days.empty()) return true;
+    if (malformed > 0) {
+        YADA_TRACE(WARNING, IO, "Skipped " << malformed << " malformed lines in day files under " << sourceDirectory);
+    }
+    if (!writeDays(days)) return false;
+
+    if (removeImported) {
+        // A file with lines that could not be read is kept aside rather than
+        // deleted, so nothing the user logged is lost without a trace
+        for (const auto& [path, skipped] : imported) {
+            if (skipped == 0) {
+                std::filesystem::remove(path, ec);
+                continue;
+            }
+            std::filesystem::path kept = path;
+            kept += ".unimported";
+            std::filesystem::rename(path, kept, ec);
+            YADA_TRACE(WARNING, IO, "Kept " << kept.string() << " with " << skipped << " unreadable lines");
+        }
+    }
+    YADA_TRACE(INFO, IO, "Imported " << days.size() << " day files from " << sourceDirectory);
+    copied = days.size();
+    return true;
+}
+
+size_t HistoryStore::exportDayFiles(const std::string& targetDirectory) {
+    std::error_code ec;
+    std::filesystem::create_directories(targetDirectory, ec);
+
+    // The year files present say which segments to walk
+    std::vector<int> years;
+    for (const auto& file : std::filesystem::directory_iterator(directory, ec)) {
+        std::string stem = file.path().stem().string();
+        if (file.path().extension() == ".seg" && !stem.empty()
+            && std::all_of(stem.begin(), stem.end(), [](char c) { return c >= '0' && c <= '9'; })) {
+            years.push_back(std::stoi(stem));
+        }
+    }
+    std::sort(years.begin(), years.end());
+
+    size_t exported = 0;
+    for (int year : years) {
+        const HistorySegment& stored = segment(year);
+        auto reader = database.read();
+        for (int index = 0; index < stored.dayCount(); ++index) {
+            if (stored.dayOffsets[index + 1] == stored.dayOffsets[index]) continue;
+            std::string path = targetDirectory + "/" + utils::fromDayNumber(stored.firstDay + index) + ".log";
+            std::ofstream file(path, std::ios::trunc);
+            if (!file.is_open()) {
+                YADA_TRACE(WARNING, IO, "Could not open log file for writing: " << path);
+                continue;
+            }
+            for (std::uint32_t row = stored.dayOffsets[index]; row < stored.dayOffsets[index + 1]; ++row) {
+                file << reader.catalog().name(stored.foods[row]) << "|" << stored.servings[row] << "|"
+                     << stored.timestamps[row] << "\n";
+            }
+            ++exported;
+        }
+    }
+    YADA_TRACE(INFO, IO, "Exported " << exported << " day files to " << targetDirectory);
+    return exported;
+}
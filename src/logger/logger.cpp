@@ -1,206 +1,739 @@
 #include "logger/logger.h"
+#include "utils/utils.h"
+#include "utils/binary_io.h"
+#include "utils/field_reader.h"
+#include "utils/trace.h"
 #include <fstream>
 #include <sstream>
-#include <iostream>
 #include <filesystem>
 #include <iomanip>
+#include <algorithm>
 
-Logger::Logger(const std::string& logDirectory, const std::string& username)
-    : logDirectory(logDirectory), username(username) {
+namespace {
+
+int floorDiv(int a, int b) {
+    return a / b - ((a % b != 0) && ((a < 0) != (b < 0)));
+}
+
+// 1970-01-01 was a Thursday, so shifting by three makes weeks start on Monday
+int weekNumber(int day) {
+    return floorDiv(day + 3, 7);
+}
+
+int weekStart(int day) {
+    return weekNumber(day) * 7 - 3;
+}
+
+int monthNumber(int day) {
+    std::string date = utils::fromDayNumber(day);
+    return std::stoi(date.substr(0, 4)) * 12 + std::stoi(date.substr(5, 2)) - 1;
+}
+
+int monthStart(int day) {
+    return utils::toDayNumber(utils::fromDayNumber(day).substr(0, 8) + "01");
+}
+
+int nextMonthStart(int day) {
+    return monthStart(monthStart(day) + 31);
+}
+
+int nextYearStart(int day) {
+    int year = std::stoi(utils::fromDayNumber(day).substr(0, 4));
+    return utils::toDayNumber(std::to_string(year + 1) + "-01-01");
+}
+
+// Spellings such as 2024-1-5 name the same day as 2024-01-05
+std::string canonicalDate(const std::string& date) {
+    return utils::isCanonicalDate(date) ? date : utils::fromDayNumber(utils::toDayNumber(date));
+}
+
+} // namespace
+
+double CalorieSummary::averageCalories() const {
+    return days > 0 ? totalCalories / days : 0.0;
+}
+
+Logger::Logger(const std::string& logDirectory, const std::string& username, Database& database)
+    : residentBytes(0), residentLimit(DEFAULT_RESIDENT_BYTES),
+      logDirectory(logDirectory), username(username), database(database),
+      undoLimit(DEFAULT_UNDO_LIMIT),
+      historyFile(logDirectory + "/" + username + "/undo.hist"),
+      operationsFile(logDirectory + "/" + username + "/journal.ops"),
+      nextSequence(1), operationCount(0), batchMode(false), rollupRevision(0),
+      history(logDirectory + "/" + username, database) {
     // Create user-specific log directory
     std::string userLogDir = logDirectory + "/" + username;
     if (!std::filesystem::exists(userLogDir)) {
         std::filesystem::create_directories(userLogDir);
     }
-    #ifdef DEBUG
-    std::cout << "DEBUG: Created Logger object for user " << username 
-              << " with directory: " << userLogDir << std::endl;
-    #endif
+
+    // Per-day files written by older versions move into the year segments
+    // once; the journal still applies on top of them. The marker keeps later
+    // logins from scanning the directory for them again.
+    std::string migratedMarker = userLogDir + "/" + MIGRATED_MARKER;
+    if (!std::filesystem::exists(migratedMarker) && history.migrateDayFiles()) {
+        std::error_code ec;
+        std::filesystem::remove(userLogDir + "/dates.idx", ec);
+        std::ofstream marker(migratedMarker);
+        YADA_TRACE(INFO, LOGGER, "Migrated day files to history segments for user: " << username);
+    }
+    readOperations();
+    readHistory();
+    YADA_TRACE(VERBOSE, LOGGER, "Created Logger object for user " << username << " with directory: " << userLogDir);
 }
 
-void Logger::loadLog(const std::string& date) {
-    std::string filePath = getLogFilePath(date);
-    std::ifstream file(filePath);
-    if (!file.is_open()) {
-        #ifdef DEBUG
-        std::cout << "DEBUG: Could not open log file: " << filePath << std::endl;
-        #endif
-        return;
+std::vector<LogEntry> Logger::readLog(const std::string& date) const {
+    std::vector<LogEntry> entries = history.readDay(utils::toDayNumber(date));
+
+    // Bring the day up to date with operations logged since the history was written
+    auto pending = pendingOperations.find(date);
+    if (pending != pendingOperations.end()) {
+        for (const auto& operation : pending->second) {
+            applyOperation(entries, operation);
+        }
     }
 
-    std::vector<LogEntry> entries;
+    YADA_TRACE(DETAIL, LOGGER, "Loaded " << entries.size() << " entries for date: " << date
+               << " for user: " << username);
+    return entries;
+}
+
+std::vector<LogEntry>& Logger::residentDay(const std::string& date) const {
+    auto it = residentDays.find(date);
+    if (it == residentDays.end()) {
+        std::vector<LogEntry> entries = readLog(date);
+        residentOrder.push_front(date);
+        it = residentDays.emplace(date, ResidentDay{std::move(entries), residentOrder.begin(), 0}).first;
+    } else {
+        residentOrder.splice(residentOrder.begin(), residentOrder, it->second.position);
+        residentBytes -= it->second.bytes;
+    }
+
+    // Sizes are refreshed on access, so an edit is accounted for the next time its day is used
+    ResidentDay& day = it->second;
+    day.bytes = sizeof(ResidentDay) + 2 * date.size() + day.entries.capacity() * sizeof(LogEntry);
+    residentBytes += day.bytes;
+    trimResident(&date);
+    return day.entries;
+}
+
+void Logger::trimResident(const std::string* keep) const {
+    while (residentBytes > residentLimit && !residentOrder.empty()) {
+        // `keep` was just moved to the front, so reaching it means it is the only day left
+        if (keep && residentOrder.back() == *keep) break;
+        auto it = residentDays.find(residentOrder.back());
+        residentBytes -= it->second.bytes;
+        YADA_TRACE(VERBOSE, LOGGER, "Evicted date " << it->first << " for user: " << username);
+        residentDays.erase(it);
+        residentOrder.pop_back();
+    }
+}
+
+bool Logger::isLogged(const std::string& date) const {
+    return residentDays.count(date) || pendingOperations.count(date) || history.hasDay(utils::toDayNumber(date));
+}
+
+bool Logger::hasPendingDays(int first, int last) const {
+    auto pending = pendingOperations.lower_bound(utils::fromDayNumber(first));
+    return pending != pendingOperations.end() && pending->first <= utils::fromDayNumber(last);
+}
+
+void Logger::readOperations() {
+    std::ifstream file(operationsFile);
+    if (!file.is_open()) return;
+
+    // sequence|type|date|undone|index|foodId|servings|timestamp
     std::string line;
+    std::uintmax_t goodBytes = 0;
+    size_t skipped = 0;
+    bool torn = false;
     while (std::getline(file, line)) {
-        std::stringstream ss(line);
-        LogEntry entry;
-        std::string timestampStr;
-        
-        std::getline(ss, entry.foodId, '|');
-        ss >> entry.servings;
-        ss.ignore(); // Skip the separator
-        std::getline(ss, timestampStr);
-        
-        entry.timestamp = std::stoll(timestampStr);
-        entries.push_back(entry);
-    }
-
-    dailyLogs[date] = entries;
-    #ifdef DEBUG
-    std::cout << "DEBUG: Loaded " << entries.size() << " entries for date: " << date 
-              << " for user: " << username << std::endl;
-    #endif
-}
-
-void Logger::saveLog(const std::string& date) const {
-    std::string filePath = getLogFilePath(date);
-    std::ofstream file(filePath);
-    if (!file.is_open()) {
-        #ifdef DEBUG
-        std::cout << "DEBUG: Could not open log file for writing: " << filePath << std::endl;
-        #endif
-        return;
-    }
+        // A last record without its newline was torn by a crash mid-append
+        if (file.eof()) {
+            YADA_TRACE(WARNING, LOGGER, "Dropping truncated operation record: " << line);
+            torn = true;
+            break;
+        }
+        goodBytes += line.size() + 1;
+        if (line.empty()) continue;
 
-    const auto& entries = dailyLogs.at(date);
-    for (const auto& entry : entries) {
-        file << entry.foodId << "|" << entry.servings << "|" << entry.timestamp << "\n";
+        utils::FieldReader fields(line);
+        std::int64_t sequence, index, timestamp;
+        bool parsed = utils::parseInt(fields.next('|'), sequence) && sequence >= 0;
+        std::string_view type = fields.next('|');
+        std::string date(fields.next('|'));
+        std::string_view undone = fields.next('|');
+        parsed = parsed && utils::parseInt(fields.next('|'), index) && index >= 0;
+        std::string_view foodId = fields.next('|');
+        int servings;
+        parsed = parsed && utils::parseInt(fields.next('|'), servings) && utils::parseInt(fields.remainder(), timestamp);
+        if (!parsed || type.size() != 1 || undone.size() != 1 || !utils::isValidDate(date)) {
+            ++skipped;
+            continue;
+        }
+
+        LogOperation operation;
+        operation.sequence = static_cast<std::uint64_t>(sequence);
+        operation.type = static_cast<LogOperation::Type>(type[0]);
+        operation.undone = static_cast<LogOperation::Type>(undone[0]);
+        operation.index = static_cast<size_t>(index);
+        operation.entry.food = database.internFood(foodId);
+        operation.entry.servings = servings;
+        operation.entry.timestamp = static_cast<std::time_t>(timestamp);
+
+        date = canonicalDate(date);
+        pendingOperations[date].push_back(operation);
+        dirtyDates.insert(date);
+        nextSequence = std::max(nextSequence, operation.sequence + 1);
+        ++operationCount;
     }
-    #ifdef DEBUG
-    std::cout << "DEBUG: Saved " << entries.size() << " entries for date: " << date 
-              << " for user: " << username << std::endl;
-    #endif
+    file.close();
+    if (skipped > 0) {
+        YADA_TRACE(WARNING, LOGGER, "Skipped " << skipped << " malformed operation records for user: " << username);
+    }
+    if (torn) {
+        // Cut the torn tail so later appends start on a fresh line
+        std::error_code ec;
+        std::filesystem::resize_file(operationsFile, goodBytes, ec);
+        if (ec) YADA_TRACE(WARNING, IO, "Could not truncate operation log: " << operationsFile);
+    }
+    YADA_TRACE(INFO, LOGGER, "Read " << operationCount << " logged operations for user: " << username);
 }
 
-std::string Logger::getLogFilePath(const std::string& date) const {
-    return logDirectory + "/" + username + "/" + date + ".log";
+LogOperation Logger::appendOperation(const std::string& date, LogOperation operation) {
+    operation.sequence = nextSequence++;
+
+    std::ostringstream record;
+    record << operation.sequence << "|" << static_cast<char>(operation.type) << "|" << date << "|"
+           << static_cast<char>(operation.undone) << "|" << operation.index << "|"
+           << database.read().catalog().name(operation.entry.food) << "|" << operation.entry.servings << "|"
+           << operation.entry.timestamp << "\n";
+    heldOperations += record.str();
+    if (!batchMode) {
+        // Only the write; callers compact once the operation is applied
+        appendHeldOperations();
+    }
+
+    pendingOperations[date].push_back(operation);
+    dirtyDates.insert(date);
+    ++operationCount;
+    return operation;
 }
 
-void Logger::pushUndoState(const std::string& date) {
-    if (dailyLogs.find(date) != dailyLogs.end()) {
-        undoStack.push_back({date, dailyLogs[date]});
+void Logger::applyOperation(std::vector<LogEntry>& entries, const LogOperation& operation) {
+    LogOperation::Type type = operation.type;
+    if (type == LogOperation::UNDO) {
+        // Undoing an add removes it again; undoing a remove puts the entry back
+        if (operation.undone == LogOperation::ADD) {
+            if (!entries.empty()) entries.pop_back();
+        } else if (operation.undone == LogOperation::REMOVE) {
+            size_t index = std::min(operation.index, entries.size());
+            entries.insert(entries.begin() + index, operation.entry);
+        }
+        return;
+    }
+
+    if (type == LogOperation::ADD) {
+        entries.push_back(operation.entry);
+    } else if (type == LogOperation::REMOVE && operation.index < entries.size()) {
+        entries.erase(entries.begin() + operation.index);
     }
 }
 
-void Logger::addEntry(const std::string& date, const std::string& foodId, int servings) {
-    if (dailyLogs.find(date) == dailyLogs.end()) {
-        loadLog(date);
+void Logger::pushUndoRecord(const std::string& date, const LogOperation& operation) {
+    undoStack.push_back({date, operation});
+    if (undoStack.size() > undoLimit) {
+        undoStack.pop_front();
     }
+    // A new edit invalidates anything that could have been redone
+    redoStack.clear();
+}
 
-    pushUndoState(date);
+void Logger::readHistory() {
+    // Operations that were never compacted mean the last session did not shut
+    // down cleanly, so the saved history may not match the logs any more
+    if (operationCount > 0) return;
 
-    LogEntry entry;
-    entry.foodId = foodId;
-    entry.servings = servings;
-    entry.timestamp = std::time(nullptr);
-    
-    dailyLogs[date].push_back(entry);
-    saveLog(date);
-    #ifdef DEBUG
-    std::cout << "DEBUG: Added entry for food " << foodId 
-              << " with " << servings << " servings on " << date << std::endl;
-    #endif
+    std::ifstream file(historyFile);
+    if (!file.is_open()) return;
+
+    // stack|date|type|index|foodId|servings|timestamp
+    std::string line;
+    size_t skipped = 0;
+    while (std::getline(file, line)) {
+        utils::FieldReader fields(line);
+        std::string_view stack = fields.next('|');
+        std::string date(fields.next('|'));
+        std::string_view type = fields.next('|');
+        std::int64_t index;
+        bool parsed = utils::parseInt(fields.next('|'), index) && index >= 0;
+        std::string_view foodId = fields.next('|');
+        int servings;
+        std::int64_t timestamp;
+        parsed = parsed && utils::parseInt(fields.next('|'), servings) && utils::parseInt(fields.remainder(), timestamp);
+        // An unreadable record costs only that undo step
+        if (!parsed || (stack != "U" && stack != "R") || type.size() != 1 || !utils::isValidDate(date)) {
+            ++skipped;
+            continue;
+        }
+
+        UndoRecord record;
+        record.date = canonicalDate(date);
+        record.operation.sequence = 0;
+        record.operation.type = static_cast<LogOperation::Type>(type[0]);
+        record.operation.undone = record.operation.type;
+        record.operation.index = static_cast<size_t>(index);
+        record.operation.entry.food = database.internFood(foodId);
+        record.operation.entry.servings = servings;
+        record.operation.entry.timestamp = static_cast<std::time_t>(timestamp);
+        (stack == "U" ? undoStack : redoStack).push_back(record);
+    }
+    if (skipped > 0) {
+        YADA_TRACE(WARNING, LOGGER, "Skipped " << skipped << " unreadable undo records for user: " << username);
+    }
 }
 
-void Logger::removeEntry(const std::string& date, size_t index) {
-    if (dailyLogs.find(date) == dailyLogs.end()) {
+void Logger::writeHistory() const {
+    std::ofstream file(historyFile, std::ios::trunc);
+    if (!file.is_open()) {
+        YADA_TRACE(WARNING, IO, "Could not open undo history for writing: " << historyFile);
         return;
     }
 
-    pushUndoState(date);
+    auto reader = database.read();
+    auto writeStack = [&](const char* stack, const std::deque<UndoRecord>& records) {
+        for (const auto& record : records) {
+            const auto& operation = record.operation;
+            file << stack << "|" << record.date << "|" << static_cast<char>(operation.type) << "|"
+                 << operation.index << "|" << reader.catalog().name(operation.entry.food) << "|"
+                 << operation.entry.servings << "|" << operation.entry.timestamp << "\n";
+        }
+    };
+    writeStack("U", undoStack);
+    writeStack("R", redoStack);
+}
+
+void Logger::addEntry(const std::string& requestedDate, FoodHandle food, int servings) {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::string date = canonicalDate(requestedDate);
+    auto& entries = residentDay(date);
 
-    if (index < dailyLogs[date].size()) {
-        dailyLogs[date].erase(dailyLogs[date].begin() + index);
-        saveLog(date);
-        #ifdef DEBUG
-        std::cout << "DEBUG: Removed entry at index " << index 
-                  << " for date: " << date << std::endl;
-        #endif
+    LogOperation operation;
+    operation.type = LogOperation::ADD;
+    operation.undone = LogOperation::ADD;
+    operation.index = entries.size();
+    operation.entry.food = food;
+    operation.entry.servings = servings;
+    operation.entry.timestamp = std::time(nullptr);
+
+    pushUndoRecord(date, operation);
+    applyOperation(entries, appendOperation(date, operation));
+    invalidateRollups(date);
+    if (!batchMode && operationCount >= COMPACT_OPERATIONS) {
+        compactLocked();
     }
+    YADA_TRACE(DETAIL, LOGGER, "Added entry for food " << database.read().catalog().name(food) << " with " << servings
+               << " servings on " << date);
 }
 
-std::vector<LogEntry> Logger::getLog(const std::string& date) const {
-    if (dailyLogs.find(date) == dailyLogs.end()) {
-        const_cast<Logger*>(this)->loadLog(date);
+bool Logger::removeEntry(const std::string& requestedDate, size_t index) {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::string date = canonicalDate(requestedDate);
+    if (!isLogged(date)) {
+        return false;
+    }
+
+    auto& entries = residentDay(date);
+    if (index >= entries.size()) {
+        return false;
+    }
+
+    LogOperation operation;
+    operation.type = LogOperation::REMOVE;
+    operation.undone = LogOperation::REMOVE;
+    operation.index = index;
+    operation.entry = entries[index];
+
+    pushUndoRecord(date, operation);
+    applyOperation(entries, appendOperation(date, operation));
+    invalidateRollups(date);
+    if (!batchMode && operationCount >= COMPACT_OPERATIONS) {
+        compactLocked();
     }
-    auto it = dailyLogs.find(date);
-    if (it == dailyLogs.end()) {
+    YADA_TRACE(DETAIL, LOGGER, "Removed entry at index " << index << " for date: " << date);
+    return true;
+}
+
+std::vector<LogEntry> Logger::getLog(const std::string& requestedDate) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::string date = canonicalDate(requestedDate);
+    // Days without a file or operations are answered without caching anything
+    if (!isLogged(date)) {
         return std::vector<LogEntry>();
     }
-    return it->second;
+    return residentDay(date);
 }
 
-double Logger::calculateTotalCalories(const std::string& date, 
-    const std::map<std::string, std::shared_ptr<Food>>& foodDatabase) const {
+double Logger::calculateTotalCalories(const std::string& requestedDate) const {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::string date = canonicalDate(requestedDate);
+    if (!isLogged(date)) {
+        return 0.0;
+    }
+    const auto& entries = residentDay(date);
+
+    // Walk the cached day in place; foods that are no longer defined contribute nothing
+    auto reader = database.read();
+    CatalogView foods = reader.view();
     double total = 0.0;
-    const auto& entries = getLog(date);
-    
     for (const auto& entry : entries) {
-        auto it = foodDatabase.find(entry.foodId);
-        if (it != foodDatabase.end()) {
-            total += it->second->calculateCalories(entry.servings);
-        }
+        total += foods.caloriesPerServing(entry.food) * entry.servings;
     }
     
     return total;
 }
 
+void Logger::invalidateRollups(const std::string& date) {
+    int day = utils::toDayNumber(date);
+    dayRollups.erase(day);
+    weekRollups.erase(weekNumber(day));
+    monthRollups.erase(monthNumber(day));
+}
+
+Logger::Rollup Logger::dayRollup(int day) {
+    auto cached = dayRollups.find(day);
+    if (cached != dayRollups.end()) return cached->second;
+
+    Rollup rollup = {0.0, 0};
+    std::string date = utils::fromDayNumber(day);
+    if (pendingOperations.count(date)) {
+        // Loading may intern food names, so the catalog is pinned only afterwards
+        const auto& entries = residentDay(date);
+        auto reader = database.read();
+        CatalogView foods = reader.view();
+        for (const auto& entry : entries) {
+            rollup.calories += foods.caloriesPerServing(entry.food) * entry.servings;
+        }
+        rollup.loggedDays = entries.empty() ? 0 : 1;
+    } else {
+        HistoryStore::Totals stored = history.total(day, day);
+        rollup = {stored.calories, stored.loggedDays};
+    }
+    dayRollups[day] = rollup;
+    return rollup;
+}
+
+void Logger::fillDayRollups(int first, int last) {
+    int missing = first;
+    while (missing <= last && dayRollups.count(missing)) ++missing;
+    if (missing > last) return;
+
+    // One batch pass over the history; days with pending edits are summed when used
+    std::vector<HistoryStore::Totals> stored = history.dailyTotals(missing, last);
+    for (int day = missing; day <= last; ++day) {
+        if (dayRollups.count(day) || pendingOperations.count(utils::fromDayNumber(day))) continue;
+        dayRollups[day] = {stored[day - missing].calories, stored[day - missing].loggedDays};
+    }
+}
+
+Logger::Rollup Logger::rangeRollup(int first, int last) {
+    // Use the coarsest cached rollup that fits entirely inside [first, last]
+    Rollup total = {0.0, 0};
+    int day = first;
+    while (day <= last) {
+        Rollup part;
+        int next;
+        int monthEnd = nextMonthStart(day) - 1;
+        if (monthStart(day) == day && monthEnd <= last) {
+            int month = monthNumber(day);
+            auto cached = monthRollups.find(month);
+            if (cached == monthRollups.end()) {
+                // Fill the month in one pass over the history, or from its
+                // weeks and edge days if some of them have pending edits
+                Rollup filled = {0.0, 0};
+                if (!hasPendingDays(day, monthEnd)) {
+                    HistoryStore::Totals stored = history.total(day, monthEnd);
+                    filled = {stored.calories, stored.loggedDays};
+                } else {
+                    fillDayRollups(day, monthEnd);
+                    for (int d = day; d <= monthEnd;) {
+                        int span = (weekStart(d) == d && d + 6 <= monthEnd) ? 7 : 1;
+                        Rollup inner = rangeRollup(d, d + span - 1);
+                        filled.calories += inner.calories;
+                        filled.loggedDays += inner.loggedDays;
+                        d += span;
+                    }
+                }
+                cached = monthRollups.insert_or_assign(month, filled).first;
+            }
+            part = cached->second;
+            next = monthEnd + 1;
+        } else if (weekStart(day) == day && day + 6 <= last) {
+            int week = weekNumber(day);
+            auto cached = weekRollups.find(week);
+            if (cached == weekRollups.end()) {
+                Rollup filled = {0.0, 0};
+                if (!hasPendingDays(day, day + 6)) {
+                    HistoryStore::Totals stored = history.total(day, day + 6);
+                    filled = {stored.calories, stored.loggedDays};
+                } else {
+                    fillDayRollups(day, day + 6);
+                    for (int d = day; d < day + 7; ++d) {
+                        Rollup inner = dayRollup(d);
+                        filled.calories += inner.calories;
+                        filled.loggedDays += inner.loggedDays;
+                    }
+                }
+                cached = weekRollups.emplace(week, filled).first;
+            }
+            part = cached->second;
+            next = day + 7;
+        } else {
+            part = dayRollup(day);
+            next = day + 1;
+        }
+        total.calories += part.calories;
+        total.loggedDays += part.loggedDays;
+        day = next;
+    }
+    return total;
+}
+
+std::vector<CalorieSummary> Logger::summarizeRange(const std::string& from, const std::string& to,
+                                                   SummaryPeriod period) {
+    std::lock_guard<std::mutex> lock(mutex);
+    // Cached totals were computed with the old calories if the catalog changed
+    std::uint64_t revision = database.read().view().revision();
+    if (revision != rollupRevision) {
+        dayRollups.clear();
+        weekRollups.clear();
+        monthRollups.clear();
+        rollupRevision = revision;
+    }
+    std::vector<CalorieSummary> summaries;
+    int first = utils::toDayNumber(from);
+    int last = utils::toDayNumber(to);
+    if (period == SummaryPeriod::DAY) {
+        fillDayRollups(first, last);
+    }
+    for (int day = first; day <= last;) {
+        int periodEnd = day;
+        switch (period) {
+            case SummaryPeriod::DAY: periodEnd = day; break;
+            case SummaryPeriod::WEEK: periodEnd = weekStart(day) + 6; break;
+            case SummaryPeriod::MONTH: periodEnd = nextMonthStart(day) - 1; break;
+            case SummaryPeriod::YEAR: periodEnd = nextYearStart(day) - 1; break;
+        }
+        int end = std::min(periodEnd, last);
+        Rollup rollup = rangeRollup(day, end);
+        summaries.push_back({utils::fromDayNumber(day), utils::fromDayNumber(end),
+                             end - day + 1, rollup.loggedDays, rollup.calories});
+        day = end + 1;
+    }
+    return summaries;
+}
+
 void Logger::undo() {
+    std::lock_guard<std::mutex> lock(mutex);
     if (!undoStack.empty()) {
-        const auto& [date, entries] = undoStack.back();
-        dailyLogs[date] = entries;
-        saveLog(date);
+        UndoRecord record = undoStack.back();
         undoStack.pop_back();
-        #ifdef DEBUG
-        std::cout << "DEBUG: Undid last operation for date: " << date << std::endl;
-        #endif
+        auto& entries = residentDay(record.date);
+
+        // Log the inverse of the recorded edit and apply it in place
+        LogOperation marker = record.operation;
+        marker.type = LogOperation::UNDO;
+        applyOperation(entries, appendOperation(record.date, marker));
+        invalidateRollups(record.date);
+        redoStack.push_back(record);
+        YADA_TRACE(DETAIL, LOGGER, "Undid last operation for date: " << record.date);
     }
 }
 
 bool Logger::canUndo() const {
+    std::lock_guard<std::mutex> lock(mutex);
     return !undoStack.empty();
 }
 
-void Logger::save() const {
-    for (const auto& [date, entries] : dailyLogs) {
-        saveLog(date);
+void Logger::redo() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!redoStack.empty()) {
+        UndoRecord record = redoStack.back();
+        redoStack.pop_back();
+        auto& entries = residentDay(record.date);
+
+        record.operation = appendOperation(record.date, record.operation);
+        applyOperation(entries, record.operation);
+        invalidateRollups(record.date);
+        undoStack.push_back(record);
+        YADA_TRACE(DETAIL, LOGGER, "Redid last undone operation for date: " << record.date);
+    }
+}
+
+bool Logger::canRedo() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return !redoStack.empty();
+}
+
+void Logger::setResidentLimit(size_t bytes) {
+    std::lock_guard<std::mutex> lock(mutex);
+    residentLimit = bytes;
+    trimResident(nullptr);
+}
+
+void Logger::setUndoLimit(size_t limit) {
+    std::lock_guard<std::mutex> lock(mutex);
+    undoLimit = limit;
+    while (undoStack.size() > undoLimit) {
+        undoStack.pop_front();
     }
-    #ifdef DEBUG
-    std::cout << "DEBUG: Saved all logs" << std::endl;
-    #endif
+}
+
+void Logger::save() {
+    std::lock_guard<std::mutex> lock(mutex);
+    compactLocked();
+    writeHistory();
+    YADA_TRACE(INFO, LOGGER, "Saved all logs");
+}
+
+void Logger::setBatchMode(bool enabled) {
+    std::lock_guard<std::mutex> lock(mutex);
+    batchMode = enabled;
+    if (!batchMode) {
+        flushLocked();
+    }
+}
+
+void Logger::flush() {
+    std::lock_guard<std::mutex> lock(mutex);
+    flushLocked();
+}
+
+void Logger::flushLocked() {
+    if (!appendHeldOperations()) return;
+    if (operationCount >= COMPACT_OPERATIONS) {
+        compactLocked();
+    }
+}
+
+bool Logger::appendHeldOperations() {
+    if (heldOperations.empty()) return true;
+    // Synced so a crash can tear at most the last record
+    if (!utils::appendFile(operationsFile, heldOperations)) {
+        YADA_TRACE(WARNING, IO, "Could not append to operation log: " << operationsFile);
+        return false;
+    }
+    heldOperations.clear();
+    return true;
+}
+
+void Logger::compact() {
+    std::lock_guard<std::mutex> lock(mutex);
+    compactLocked();
+}
+
+void Logger::compactLocked() {
+    // Held records must reach the log before it is folded and truncated
+    appendHeldOperations();
+    if (dirtyDates.empty()) return;
+
+    // Evicted days are rebuilt from the history and pending operations first
+    std::map<int, std::vector<LogEntry>> days;
+    for (const auto& date : dirtyDates) {
+        days[utils::toDayNumber(date)] = residentDay(date);
+    }
+    if (!history.writeDays(days)) {
+        // The journal still holds every edit, so nothing is lost
+        YADA_TRACE(WARNING, LOGGER, "Kept operation log after failed compaction for user: " << username);
+        return;
+    }
+
+    // Every logged operation is now reflected in the history, including any
+    // held records that could not be appended
+    if (!utils::writeFile(operationsFile, nullptr, 0, "")) {
+        YADA_TRACE(WARNING, IO, "Could not truncate operation log: " << operationsFile);
+    }
+    heldOperations.clear();
+    writeHistory();
+    pendingOperations.clear();
+    dirtyDates.clear();
+    operationCount = 0;
+    YADA_TRACE(INFO, LOGGER, "Compacted operation log for user: " << username);
+}
+
+size_t Logger::importDayFiles(const std::string& directory) {
+    std::lock_guard<std::mutex> lock(mutex);
+    // Imported days replace stored ones, so no edit may be left on top of them
+    compactLocked();
+    if (!pendingOperations.empty()) return 0;
+
+    size_t imported = history.importDayFiles(directory, false);
+    if (imported > 0) {
+        residentDays.clear();
+        residentOrder.clear();
+        residentBytes = 0;
+        dayRollups.clear();
+        weekRollups.clear();
+        monthRollups.clear();
+        undoStack.clear();
+        redoStack.clear();
+        writeHistory();
+    }
+    return imported;
+}
+
+size_t Logger::exportDayFiles(const std::string& directory) {
+    std::lock_guard<std::mutex> lock(mutex);
+    compactLocked();
+    if (!pendingOperations.empty()) return 0;
+    return history.exportDayFiles(directory);
 }
 
 void Logger::load() {
-    dailyLogs.clear();
+    std::lock_guard<std::mutex> lock(mutex);
+    residentDays.clear();
+    residentOrder.clear();
+    residentBytes = 0;
     undoStack.clear();
-    
+    redoStack.clear();
+    pendingOperations.clear();
+    dayRollups.clear();
+    weekRollups.clear();
+    monthRollups.clear();
+    history.clearCache();
+    dirtyDates.clear();
+    operationCount = 0;
+    // Records held for a batch describe the state being discarded, and the
+    // sequence continues from what the reread log holds, as on construction
+    heldOperations.clear();
+    nextSequence = 1;
+
     std::string userLogDir = logDirectory + "/" + username;
     if (!std::filesystem::exists(userLogDir)) {
         std::filesystem::create_directories(userLogDir);
     }
-    
-    for (const auto& entry : std::filesystem::directory_iterator(userLogDir)) {
-        if (entry.path().extension() == ".log") {
-            std::string date = entry.path().stem().string();
-            loadLog(date);
-        }
-    }
-    #ifdef DEBUG
-    std::cout << "DEBUG: Loaded all logs for user: " << username << std::endl;
-    #endif
+    readOperations();
+    readHistory();
+    YADA_TRACE(INFO, LOGGER, "Reloaded operation log and history for user: " << username);
 }
 
-#ifdef DEBUG
 void Logger::debugPrint() const {
-    std::cout << "DEBUG: Logger Contents:" << std::endl;
-    for (const auto& [date, entries] : dailyLogs) {
-        std::cout << "Date: " << date << std::endl;
-        std::cout << "Entries:" << std::endl;
-        for (const auto& entry : entries) {
-            std::cout << "  - Food ID: " << entry.foodId 
-                      << ", Servings: " << entry.servings 
-                      << ", Timestamp: " << entry.timestamp << std::endl;
+    if (!YADA_TRACE_ON(VERBOSE, LOGGER)) return;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto reader = database.read();
+    std::ostringstream out;
+    out << "Logger Contents (" << residentDays.size() << " resident days, " << residentBytes << " bytes):\n";
+    for (const auto& [date, day] : residentDays) {
+        out << "Date: " << date << "\n";
+        out << "Entries:\n";
+        for (const auto& entry : day.entries) {
+            out << "  - Food ID: " << reader.catalog().name(entry.food)
+                << ", Servings: " << entry.servings
+                << ", Timestamp: " << entry.timestamp << "\n";
         }
     }
-    std::cout << "Undo Stack Size: " << undoStack.size() << std::endl;
-}
-#endif 
\ No newline at end of file
+    out << "Undo Stack Size: " << undoStack.size() << "\n";
+    out << "Redo Stack Size: " << redoStack.size();
+    YADA_TRACE(VERBOSE, LOGGER, out.str());
+}
\ No newline at end of file
@@ -2,28 +2,39 @@
 #include <string>
 #include <vector>
 #include <memory>
-#include <map>
 #include <fstream>
 #include <sstream>
-#include "user/user.h"
-#include "database/database.h"
-#include "logger/logger.h"
+#include <iomanip>
+#include <chrono>
+#include <algorithm>
+#include "api/command_interpreter.h"
+#include "api/yada_service.h"
 #include "utils/utils.h"
-
+#include "utils/trace.h"
+#ifndef _WIN32
+#include <csignal>
+#include <thread>
+#include <unistd.h>
+#include "server/protocol.h"
+#include "server/session_client.h"
+#include "server/session_server.h"
+#endif
+
+// Interactive front end; all state and business rules live in YadaService
 class YADA {
 private:
-    std::shared_ptr<User> currentUser;
-    std::unique_ptr<Database> database;
-    std::unique_ptr<Logger> logger;
-    std::map<std::string, std::shared_ptr<User>> users;
+    // Search results shown before asking whether to show more
+    static constexpr size_t SEARCH_PAGE_SIZE = 10;
+
+    YadaService service;
+    std::shared_ptr<UserSession> session;
     std::string currentDate;
 
-    void loadUsers();
-    void saveUsers() const;
     bool login(const std::string& username, const std::string& password);
     bool registerUser(const std::string& username, const std::string& password,
                      Gender gender, double height, int age, double weight,
                      ActivityLevel activityLevel);
+    void logout();
     void showMainMenu();
     void showFoodMenu();
     void showLogMenu();
@@ -36,130 +47,45 @@ private:
     void deleteFromLog();
     void updateProfile();
     void showCalorieSummary();
+    void showCalorieReport();
     void showLoginMenu();
     void login();
     void registerUser();
 
 public:
-    YADA() : currentDate(utils::getCurrentDate()) {
-        #ifdef DEBUG
-        utils::printDebug("Initializing YADA");
-        #endif
-
-        // Create necessary directories
-        utils::createDirectory("data");
-        utils::createDirectory("data/daily_logs");
-
-        // Initialize components
-        database = std::make_unique<Database>("data/basic_foods.txt", "data/composite_foods.txt");
-        logger = std::make_unique<Logger>("data/daily_logs", "");  // Empty username initially
-
-        // Load user data
-        loadUsers();
-        #ifdef DEBUG
-        std::cout << "DEBUG: Created YADA object" << std::endl;
-        #endif
+    YADA() : service("data"), currentDate(utils::getCurrentDate()) {
+        YADA_TRACE(VERBOSE, APP, "Created YADA object");
     }
 
     void run();
+    int runBatch(std::istream& input);
 };
 
-void YADA::loadUsers() {
-    std::ifstream file("data/users.txt");
-    if (!file.is_open()) {
-        #ifdef DEBUG
-        utils::printDebug("No users file found, starting fresh");
-        #endif
-        return;
-    }
-
-    std::string line;
-    while (std::getline(file, line)) {
-        std::stringstream ss(line);
-        std::string username, passwordHash, genderStr;
-        double height;
-        int age;
-        double weight;
-        int activityLevel;
-
-        std::getline(ss, username, '|');
-        std::getline(ss, passwordHash, '|');
-        std::getline(ss, genderStr, '|');
-        ss >> height >> age >> weight >> activityLevel;
-
-        Gender gender = (genderStr == "MALE") ? Gender::MALE :
-                       (genderStr == "FEMALE") ? Gender::FEMALE : Gender::OTHER;
-
-        users[username] = std::make_shared<User>(username, passwordHash, gender,
-                                                height, age, weight,
-                                                static_cast<ActivityLevel>(activityLevel));
-    }
-    #ifdef DEBUG
-    utils::printDebug("Loaded " + std::to_string(users.size()) + " users");
-    #endif
-}
-
-void YADA::saveUsers() const {
-    std::ofstream file("data/users.txt");
-    if (!file.is_open()) {
-        #ifdef DEBUG
-        utils::printDebug("Could not open users file for writing");
-        #endif
-        return;
-    }
-
-    for (const auto& [username, user] : users) {
-        file << username << "|" << user->getPasswordHash() << "|"
-             << (user->getGender() == Gender::MALE ? "MALE" :
-                 user->getGender() == Gender::FEMALE ? "FEMALE" : "OTHER") << "|"
-             << user->getHeight() << " " << user->getAge() << " "
-             << user->getWeight() << " " << static_cast<int>(user->getActivityLevel()) << "\n";
-    }
-    #ifdef DEBUG
-    utils::printDebug("Saved " + std::to_string(users.size()) + " users");
-    #endif
-}
-
 bool YADA::login(const std::string& username, const std::string& password) {
-    auto it = users.find(username);
-    if (it == users.end()) {
-        std::cout << "User not found.\n";
+    auto result = service.login(username, password);
+    if (!result.ok) {
+        std::cout << result.error << "\n";
         return false;
     }
+    session = result.value;
+    std::cout << "Login successful!\n";
+    return true;
+}
 
-    if (utils::verifyPassword(password, it->second->getPasswordHash())) {
-        currentUser = it->second;
-        logger = std::make_unique<Logger>("data/daily_logs", username);
-        std::cout << "Login successful!\n";
-        return true;
-    }
-
-    std::cout << "Invalid password.\n";
-    return false;
+void YADA::logout() {
+    // Fold this session's operation log into the per-day files
+    session->save();
+    session = nullptr;
 }
 
 bool YADA::registerUser(const std::string& username, const std::string& password,
                        Gender gender, double height, int age, double weight,
                        ActivityLevel activityLevel) {
-    if (users.find(username) != users.end()) {
-        std::cout << "Username already exists.\n";
-        return false;
-    }
-
-    if (!utils::isValidUsername(username)) {
-        std::cout << "Invalid username format.\n";
-        return false;
-    }
-
-    if (!utils::isValidPassword(password)) {
-        std::cout << "Invalid password format.\n";
+    Status status = service.registerUser(username, password, gender, height, age, weight, activityLevel);
+    if (!status.ok) {
+        std::cout << status.error << "\n";
         return false;
     }
-
-    std::string passwordHash = utils::hashPassword(password);
-    users[username] = std::make_shared<User>(username, passwordHash, gender,
-                                            height, age, weight, activityLevel);
-    saveUsers();
     std::cout << "Registration successful!\n";
     return true;
 }
@@ -171,7 +97,8 @@ void YADA::showMainMenu() {
                   << "2. Daily Log\n"
                   << "3. Profile Settings\n"
                   << "4. Calorie Summary\n"
-                  << "5. Logout\n"
+                  << "5. Calorie Report (date range)\n"
+                  << "6. Logout\n"
                   << "Choice: ";
 
         int choice;
@@ -183,9 +110,9 @@ void YADA::showMainMenu() {
             case 2: showLogMenu(); break;
             case 3: showProfileMenu(); break;
             case 4: showCalorieSummary(); break;
-            case 5: 
-                currentUser = nullptr;
-                logger = std::make_unique<Logger>("data/daily_logs", "");
+            case 5: showCalorieReport(); break;
+            case 6:
+                logout();
                 return;
             default: std::cout << "Invalid choice.\n";
         }
@@ -222,7 +149,8 @@ void YADA::showLogMenu() {
                   << "2. View Log\n"
                   << "3. Delete from Log\n"
                   << "4. Undo Last Action\n"
-                  << "5. Back to Main Menu\n"
+                  << "5. Redo Last Undone Action\n"
+                  << "6. Back to Main Menu\n"
                   << "Choice: ";
 
         int choice;
@@ -233,15 +161,17 @@ void YADA::showLogMenu() {
             case 1: addFoodToLog(); break;
             case 2: viewLog(); break;
             case 3: deleteFromLog(); break;
-            case 4: 
-                if (logger->canUndo()) {
-                    logger->undo();
-                    std::cout << "Last action undone.\n";
-                } else {
-                    std::cout << "Nothing to undo.\n";
-                }
+            case 4: {
+                Status status = session->undo();
+                std::cout << (status.ok ? "Last action undone." : status.error) << "\n";
+                break;
+            }
+            case 5: {
+                Status status = session->redo();
+                std::cout << (status.ok ? "Last undone action redone." : status.error) << "\n";
                 break;
-            case 5: return;
+            }
+            case 6: return;
             default: std::cout << "Invalid choice.\n";
         }
     }
@@ -261,7 +191,7 @@ void YADA::showProfileMenu() {
 
         switch (choice) {
             case 1: updateProfile(); break;
-            case 2: std::cout << currentUser->toString() << "\n"; break;
+            case 2: std::cout << session->getUser()->toString() << "\n"; break;
             case 3: return;
             default: std::cout << "Invalid choice.\n";
         }
@@ -284,14 +214,14 @@ void YADA::addBasicFood() {
     std::getline(std::cin, keyword);
     keywords = utils::splitString(keyword, ',');
 
-    database->addBasicFood(id, keywords, calories);
-    database->save();
-    std::cout << "Basic food added successfully!\n";
+    Status status = service.addBasicFood(id, keywords, calories);
+    std::cout << (status.ok ? "Basic food added successfully!" : status.error) << "\n";
 }
 
 void YADA::addCompositeFood() {
     std::string id, keyword;
     std::vector<std::string> keywords;
+    std::vector<FoodComponentInfo> components;
 
     std::cout << "Enter composite food identifier: ";
     std::getline(std::cin, id);
@@ -300,8 +230,6 @@ void YADA::addCompositeFood() {
     std::getline(std::cin, keyword);
     keywords = utils::splitString(keyword, ',');
 
-    database->addCompositeFood(id, keywords);
-
     while (true) {
         std::cout << "Add component (y/n)? ";
         char choice;
@@ -320,20 +248,16 @@ void YADA::addCompositeFood() {
         std::cin >> servings;
         std::cin.ignore();
 
-        auto food = database->getFood(componentId);
-        if (food) {
-            auto compositeFood = database->getCompositeFood(id);
-            if (compositeFood) {
-                compositeFood->addComponent(food, servings);
-                std::cout << "Component added successfully!\n";
-            }
+        if (service.foodExists(componentId) && componentId != id) {
+            components.push_back({componentId, servings});
+            std::cout << "Component added successfully!\n";
         } else {
             std::cout << "Food not found.\n";
         }
     }
 
-    database->save();
-    std::cout << "Composite food added successfully!\n";
+    Status status = service.addCompositeFood(id, keywords, components);
+    std::cout << (status.ok ? "Composite food added successfully!" : status.error) << "\n";
 }
 
 void YADA::searchFoods() {
@@ -348,33 +272,53 @@ void YADA::searchFoods() {
     std::cin.ignore();
 
     bool matchAll = (choice == 'y' || choice == 'Y');
-    auto results = database->searchAllFoods(keywords, matchAll);
+    KeywordMatch match = KeywordMatch::EXACT;
+    auto page = service.searchFoodsRanked(keywords, matchAll, SEARCH_PAGE_SIZE);
 
-    if (results.empty()) {
+    // Rather than leave the user guessing, widen to partial words and then to near spellings
+    if (page.foods.empty()) {
+        match = KeywordMatch::PREFIX;
+        page = service.searchFoodsRanked(keywords, matchAll, SEARCH_PAGE_SIZE, SearchCursor(), match);
+        if (!page.foods.empty()) std::cout << "No exact matches; showing keywords that start with your search.\n";
+    }
+    if (page.foods.empty()) {
+        match = KeywordMatch::FUZZY;
+        page = service.searchFoodsRanked(keywords, matchAll, SEARCH_PAGE_SIZE, SearchCursor(), match);
+        if (!page.foods.empty()) std::cout << "No exact matches; showing keywords with similar spellings.\n";
+    }
+    if (page.foods.empty()) {
         std::cout << "No foods found matching your search criteria.\n";
         return;
     }
 
-    std::cout << "\nSearch Results:\n";
-    for (const auto& food : results) {
-        std::cout << "----------------------------------------\n";
-        std::cout << "ID: " << food->getIdentifier() << "\n";
-        std::cout << "Type: " << (dynamic_cast<CompositeFood*>(food.get()) ? "Composite Food" : "Basic Food") << "\n";
-        std::cout << "Keywords: ";
-        for (const auto& kw : food->getKeywords()) {
-            std::cout << kw << ", ";
-        }
-        std::cout << "\n";
-        std::cout << "Calories per serving: " << food->calculateCalories(1) << "\n";
-        
-        if (auto composite = dynamic_cast<CompositeFood*>(food.get())) {
-            std::cout << "Components:\n";
-            for (const auto& [componentId, componentPair] : composite->getComponents()) {
-                const auto& [component, servings] = componentPair;
-                std::cout << "  - " << componentId << " (" << servings << " servings)\n";
+    std::cout << "\nSearch Results (best matches first):\n";
+    while (true) {
+        for (const auto& food : page.foods) {
+            std::cout << "----------------------------------------\n";
+            std::cout << "ID: " << food.id << "\n";
+            std::cout << "Type: " << (food.composite ? "Composite Food" : "Basic Food") << "\n";
+            std::cout << "Keywords: ";
+            for (const auto& kw : food.keywords) {
+                std::cout << kw << ", ";
             }
+            std::cout << "\n";
+            std::cout << "Calories per serving: " << food.caloriesPerServing << "\n";
+
+            if (food.composite) {
+                std::cout << "Components:\n";
+                for (const auto& component : food.components) {
+                    std::cout << "  - " << component.foodId << " (" << component.servings << " servings)\n";
+                }
+            }
+            std::cout << "----------------------------------------\n\n";
         }
-        std::cout << "----------------------------------------\n\n";
+        if (!page.more) break;
+
+        std::cout << "Show more results (y/n)? ";
+        std::cin >> choice;
+        std::cin.ignore();
+        if (choice != 'y' && choice != 'Y') break;
+        page = service.searchFoodsRanked(keywords, matchAll, SEARCH_PAGE_SIZE, page.next, match);
     }
 }
 
@@ -389,13 +333,8 @@ void YADA::addFoodToLog() {
     std::cin >> servings;
     std::cin.ignore();
 
-    auto food = database->getFood(foodId);
-    if (food) {
-        logger->addEntry(currentDate, foodId, servings);
-        std::cout << "Food added to log successfully!\n";
-    } else {
-        std::cout << "Food not found.\n";
-    }
+    Status status = session->addEntry(currentDate, foodId, servings);
+    std::cout << (status.ok ? "Food added to log successfully!" : status.error) << "\n";
 }
 
 void YADA::viewLog() {
@@ -407,25 +346,22 @@ void YADA::viewLog() {
         date = currentDate;
     }
 
-    if (!utils::isValidDate(date)) {
-        std::cout << "Invalid date format.\n";
+    auto log = session->getLog(date);
+    if (!log.ok) {
+        std::cout << log.error << "\n";
         return;
     }
-
-    auto entries = logger->getLog(date);
-    if (entries.empty()) {
+    if (log.value.empty()) {
         std::cout << "No entries found for " << date << "\n";
         return;
     }
 
     std::cout << "\nLog for " << date << ":\n";
-    for (size_t i = 0; i < entries.size(); ++i) {
-        const auto& entry = entries[i];
-        auto food = database->getFood(entry.foodId);
-        if (food) {
-            std::cout << i + 1 << ". " << food->getIdentifier() 
-                      << " (" << entry.servings << " servings) - "
-                      << food->calculateCalories(entry.servings) << " calories\n";
+    for (const auto& item : log.value) {
+        if (item.defined) {
+            std::cout << item.index + 1 << ". " << item.foodId
+                      << " (" << item.servings << " servings) - "
+                      << item.calories << " calories\n";
         }
     }
 }
@@ -439,24 +375,21 @@ void YADA::deleteFromLog() {
         date = currentDate;
     }
 
-    if (!utils::isValidDate(date)) {
-        std::cout << "Invalid date format.\n";
+    auto log = session->getLog(date);
+    if (!log.ok) {
+        std::cout << log.error << "\n";
         return;
     }
-
-    auto entries = logger->getLog(date);
-    if (entries.empty()) {
+    if (log.value.empty()) {
         std::cout << "No entries found for " << date << "\n";
         return;
     }
 
     std::cout << "\nLog for " << date << ":\n";
-    for (size_t i = 0; i < entries.size(); ++i) {
-        const auto& entry = entries[i];
-        auto food = database->getFood(entry.foodId);
-        if (food) {
-            std::cout << i + 1 << ". " << food->getIdentifier() 
-                      << " (" << entry.servings << " servings)\n";
+    for (const auto& item : log.value) {
+        if (item.defined) {
+            std::cout << item.index + 1 << ". " << item.foodId
+                      << " (" << item.servings << " servings)\n";
         }
     }
 
@@ -465,12 +398,9 @@ void YADA::deleteFromLog() {
     std::cin >> index;
     std::cin.ignore();
 
-    if (index > 0 && index <= entries.size()) {
-        logger->removeEntry(date, index - 1);
-        std::cout << "Entry deleted successfully!\n";
-    } else {
-        std::cout << "Invalid entry number.\n";
-    }
+    Status status = index > 0 ? session->removeEntry(date, index - 1)
+                              : Status::failure("Invalid entry number.");
+    std::cout << (status.ok ? "Entry deleted successfully!" : status.error) << "\n";
 }
 
 void YADA::updateProfile() {
@@ -499,10 +429,9 @@ void YADA::updateProfile() {
     std::cin.ignore();
 
     if (activityLevel >= 1 && activityLevel <= 5) {
-        currentUser->updateProfile(height, age, weight, static_cast<ActivityLevel>(activityLevel - 1));
-        users[currentUser->getUsername()] = currentUser;
-        saveUsers();
-        std::cout << "Profile updated successfully!\n";
+        Status status = service.updateProfile(session->getUser()->getUsername(), height, age, weight,
+                                              static_cast<ActivityLevel>(activityLevel - 1));
+        std::cout << (status.ok ? "Profile updated successfully!" : status.error) << "\n";
     } else {
         std::cout << "Invalid activity level.\n";
     }
@@ -517,18 +446,68 @@ void YADA::showCalorieSummary() {
         date = currentDate;
     }
 
-    if (!utils::isValidDate(date)) {
-        std::cout << "Invalid date format.\n";
+    auto summary = session->summarize(date);
+    if (!summary.ok) {
+        std::cout << summary.error << "\n";
         return;
     }
 
-    double consumedCalories = logger->calculateTotalCalories(date, database->getAllFoods());
-    double targetCalories = currentUser->calculateTargetCalories();
-
     std::cout << "\nCalorie Summary for " << date << ":\n"
-              << "Consumed: " << consumedCalories << " calories\n"
-              << "Target: " << targetCalories << " calories\n"
-              << "Difference: " << (consumedCalories - targetCalories) << " calories\n";
+              << "Consumed: " << summary.value.consumedCalories << " calories\n"
+              << "Target: " << summary.value.targetCalories << " calories\n"
+              << "Difference: " << summary.value.difference() << " calories\n";
+}
+
+void YADA::showCalorieReport() {
+    std::string from, to;
+    std::cout << "Enter start date (YYYY-MM-DD): ";
+    std::getline(std::cin, from);
+    std::cout << "Enter end date (YYYY-MM-DD) or press Enter for today: ";
+    std::getline(std::cin, to);
+
+    if (to.empty()) {
+        to = currentDate;
+    }
+
+    if (!utils::isValidDate(from) || !utils::isValidDate(to) || from > to) {
+        std::cout << "Invalid date range.\n";
+        return;
+    }
+
+    std::cout << "Group by:\n"
+              << "1. Day\n"
+              << "2. Week\n"
+              << "3. Month\n"
+              << "4. Year\n"
+              << "Choice: ";
+    int choice;
+    std::cin >> choice;
+    std::cin.ignore();
+
+    if (choice < 1 || choice > 4) {
+        std::cout << "Invalid choice.\n";
+        return;
+    }
+
+    auto report = session->report(from, to, static_cast<SummaryPeriod>(choice - 1));
+    if (!report.ok) {
+        std::cout << report.error << "\n";
+        return;
+    }
+
+    std::cout << "\nCalorie Report " << from << " to " << to << ":\n";
+    for (const auto& summary : report.value.periods) {
+        std::cout << summary.startDate;
+        if (summary.endDate != summary.startDate) {
+            std::cout << " to " << summary.endDate;
+        }
+        std::cout << ": " << summary.totalCalories << " calories, "
+                  << summary.averageCalories() << " per day ("
+                  << summary.loggedDays << "/" << summary.days << " days logged)\n";
+    }
+    std::cout << "Total: " << report.value.totalCalories << " calories\n"
+              << "Average per day: " << report.value.averageCalories() << " calories\n"
+              << "Target per day: " << report.value.targetCalories << " calories\n";
 }
 
 void YADA::showLoginMenu() {
@@ -565,14 +544,7 @@ void YADA::login() {
     std::cout << "Enter password: ";
     std::getline(std::cin, password);
 
-    auto it = users.find(username);
-    if (it != users.end() && utils::verifyPassword(password, it->second->getPasswordHash())) {
-        currentUser = it->second;
-        logger = std::make_unique<Logger>("data/daily_logs", username);
-        std::cout << "Login successful!\n";
-    } else {
-        std::cout << "Invalid username or password.\n";
-    }
+    login(username, password);
 }
 
 void YADA::registerUser() {
@@ -600,7 +572,7 @@ void YADA::registerUser() {
         return;
     }
 
-    if (users.find(username) != users.end()) {
+    if (service.userExists(username)) {
         std::cout << "Username already exists.\n";
         return;
     }
@@ -646,7 +618,7 @@ void YADA::registerUser() {
 
 void YADA::run() {
     while (true) {
-        if (!currentUser) {
+        if (!session) {
             showLoginMenu();
         } else {
             showMainMenu();
@@ -654,8 +626,127 @@ void YADA::run() {
     }
 }
 
-int main() {
+namespace {
+std::string formatMs(double ms) {
+    std::ostringstream ss;
+    ss << std::fixed << std::setprecision(3) << ms << " ms";
+    return ss.str();
+}
+
+#ifndef _WIN32
+SessionServer* activeServer = nullptr;
+
+void stopServer(int) {
+    if (activeServer) activeServer->stop();
+}
+
+int serve(const std::string& socketPath, size_t workers) {
+    YadaService service("data");
+    SessionServer server(service, socketPath, workers);
+    activeServer = &server;
+    std::signal(SIGINT, stopServer);
+    std::signal(SIGTERM, stopServer);
+    std::cout << "Serving on " << socketPath << " (Ctrl-C to stop)" << std::endl;
+    int status = server.run();
+    activeServer = nullptr;
+    return status;
+}
+#endif
+
+int usage(const char* program) {
+    std::cerr << "Usage: " << program << " [--batch <file>|-]\n"
+#ifndef _WIN32
+              << "       " << program << " --serve [socket] [--workers N]\n"
+              << "       " << program << " --client [socket]\n"
+#endif
+        ;
+    return 1;
+}
+}
+
+// Batch mode: one command per line in the CommandInterpreter grammar.
+// Writes are held until "commit" or end of input.
+int YADA::runBatch(std::istream& input) {
+    using Clock = std::chrono::steady_clock;
+
+    service.setBatchMode(true);
+    CommandInterpreter interpreter(service, true, true);
+    size_t commands = 0, failures = 0;
+    double totalMs = 0.0;
+    std::string line;
+    size_t lineNumber = 0;
+
+    while (std::getline(input, line)) {
+        ++lineNumber;
+        auto args = CommandInterpreter::tokenize(line);
+        if (args.empty()) continue;
+
+        auto start = Clock::now();
+        bool ok = interpreter.execute(args, std::cout);
+        double elapsedMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+        ++commands;
+        totalMs += elapsedMs;
+        if (!ok) ++failures;
+        std::cout << "[" << lineNumber << "] " << args[0] << (ok ? " ok " : " failed ")
+                  << formatMs(elapsedMs) << "\n";
+    }
+
+    auto start = Clock::now();
+    interpreter.commit();
+    double commitMs = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    totalMs += commitMs;
+
+    std::cout << "Batch finished: " << commands << " commands, " << failures << " failed, "
+              << formatMs(totalMs) << " total (" << formatMs(commitMs) << " final commit)\n";
+    return failures == 0 ? 0 : 1;
+}
+
+int main(int argc, char* argv[]) {
+    std::vector<std::string> args(argv + 1, argv + argc);
+
+#ifndef _WIN32
+    // The client never touches the data files, so it starts before anything is loaded
+    if (!args.empty() && args[0] == "--client") {
+        if (args.size() > 2) return usage(argv[0]);
+        std::string socketPath = args.size() == 2 ? args[1] : protocol::DEFAULT_SOCKET_PATH;
+        return runSessionClient(socketPath, std::cin, std::cout, ::isatty(STDIN_FILENO));
+    }
+    if (!args.empty() && args[0] == "--serve") {
+        std::string socketPath = protocol::DEFAULT_SOCKET_PATH;
+        size_t workers = std::max(std::thread::hardware_concurrency(), 1u);
+        for (size_t i = 1; i < args.size(); ++i) {
+            if (args[i] == "--workers" && i + 1 < args.size()) {
+                std::istringstream count(args[++i]);
+                if (!(count >> workers) || workers == 0) return usage(argv[0]);
+            } else if (i == 1) {
+                socketPath = args[i];
+            } else {
+                return usage(argv[0]);
+            }
+        }
+        return serve(socketPath, workers);
+    }
+#endif
+
     YADA yada;
+
+    if (args.size() == 2 && args[0] == "--batch") {
+        const std::string& path = args[1];
+        if (path == "-") {
+            return yada.runBatch(std::cin);
+        }
+        std::ifstream script(path);
+        if (!script.is_open()) {
+            std::cerr << "Could not open batch file: " << path << "\n";
+            return 1;
+        }
+        return yada.runBatch(script);
+    }
+    if (!args.empty()) {
+        return usage(argv[0]);
+    }
+
     yada.run();
     return 0;
-} 
\ No newline at end of file
+}
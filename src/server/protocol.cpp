@@ -0,0 +1,35 @@
+#include "server/protocol.h"
+
+namespace protocol {
+
+std::string encodeResponse(const std::string& output, bool ok) {
+    std::string response;
+    response.reserve(output.size() + 16);
+    size_t start = 0;
+    while (start < output.size()) {
+        size_t end = output.find('\n', start);
+        if (end == std::string::npos) end = output.size();
+        if (output[start] == MARKER) response += MARKER;
+        response.append(output, start, end - start);
+        response += '\n';
+        start = end + 1;
+    }
+    response += ok ? STATUS_OK : STATUS_FAILED;
+    response += '\n';
+    return response;
+}
+
+bool decodeLine(const std::string& line, std::string& text, bool& ok) {
+    if (line.size() >= 2 && line[0] == MARKER && line[1] == MARKER) {
+        text = line.substr(1);
+        return true;
+    }
+    if (!line.empty() && line[0] == MARKER) {
+        ok = line == STATUS_OK;
+        return false;
+    }
+    text = line;
+    return true;
+}
+
+} // namespace protocol
@@ -0,0 +1,87 @@
+#include "server/session_client.h"
+#include "server/protocol.h"
+#include "api/command_interpreter.h"
+#include <cerrno>
+#include <cstring>
+#include <istream>
+#include <ostream>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+bool sendAll(int fd, const std::string& data) {
+    size_t offset = 0;
+    while (offset < data.size()) {
+        ssize_t sent = ::send(fd, data.data() + offset, data.size() - offset, MSG_NOSIGNAL);
+        if (sent <= 0) return false;
+        offset += static_cast<size_t>(sent);
+    }
+    return true;
+}
+
+// Reads one '\n'-terminated line, keeping any bytes after it in `buffer`
+bool readLine(int fd, std::string& buffer, std::string& line) {
+    size_t end;
+    while ((end = buffer.find('\n')) == std::string::npos) {
+        char chunk[4096];
+        ssize_t received = ::recv(fd, chunk, sizeof(chunk), 0);
+        if (received <= 0) return false;
+        buffer.append(chunk, static_cast<size_t>(received));
+    }
+    line = buffer.substr(0, end);
+    buffer.erase(0, end + 1);
+    return true;
+}
+
+} // namespace
+
+int runSessionClient(const std::string& socketPath, std::istream& input, std::ostream& output,
+                     bool interactive) {
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    if (socketPath.size() >= sizeof(address.sun_path)) {
+        output << "Socket path is too long: " << socketPath << "\n";
+        return 2;
+    }
+    std::strncpy(address.sun_path, socketPath.c_str(), sizeof(address.sun_path) - 1);
+
+    int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0 || ::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+        output << "Could not connect to " << socketPath << ": " << std::strerror(errno) << "\n";
+        if (fd >= 0) ::close(fd);
+        return 2;
+    }
+
+    int status = 0;
+    std::string buffer;
+    std::string line;
+    while (true) {
+        if (interactive) output << "yada> " << std::flush;
+        if (!std::getline(input, line)) break;
+        if (CommandInterpreter::tokenize(line).empty()) continue;
+        if (line == "quit" || line == "exit") break;
+
+        if (!sendAll(fd, line + "\n")) {
+            output << "Connection to server lost.\n";
+            status = 2;
+            break;
+        }
+        std::string reply;
+        std::string text;
+        bool ok = false;
+        bool connected;
+        while ((connected = readLine(fd, buffer, reply)) && protocol::decodeLine(reply, text, ok)) {
+            output << text << "\n";
+        }
+        if (!connected) {
+            output << "Connection to server lost.\n";
+            status = 2;
+            break;
+        }
+        if (!ok) status = 1;
+    }
+    ::close(fd);
+    return status;
+}
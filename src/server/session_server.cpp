@@ -0,0 +1,216 @@
+#include "server/session_server.h"
+#include "server/protocol.h"
+#include "utils/trace.h"
+#include <cerrno>
+#include <cstring>
+#include <sstream>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+SessionServer::Connection::Connection(int fd, YadaService& service)
+    : fd(fd), interpreter(service, false, false), closing(false) {}
+
+SessionServer::SessionServer(YadaService& service, const std::string& socketPath, size_t workers)
+    : service(service), socketPath(socketPath), workerCount(workers > 0 ? workers : 1),
+      listenFd(-1), wakePipe{-1, -1}, stopping(false) {}
+
+SessionServer::~SessionServer() {
+    if (listenFd >= 0) ::close(listenFd);
+    if (wakePipe[0] >= 0) ::close(wakePipe[0]);
+    if (wakePipe[1] >= 0) ::close(wakePipe[1]);
+}
+
+bool SessionServer::listen() {
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    if (socketPath.size() >= sizeof(address.sun_path)) {
+        YADA_TRACE(ERROR, APP, "Socket path is too long: " << socketPath);
+        return false;
+    }
+    std::strncpy(address.sun_path, socketPath.c_str(), sizeof(address.sun_path) - 1);
+
+    listenFd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listenFd < 0 || ::pipe2(wakePipe, O_CLOEXEC | O_NONBLOCK) != 0) {
+        YADA_TRACE(ERROR, IO, "Could not create server socket: " << std::strerror(errno));
+        return false;
+    }
+    // A socket file left by a server that did not shut down cleanly
+    ::unlink(socketPath.c_str());
+    // Sessions carry account access, so only the owner may connect
+    mode_t previous = ::umask(0077);
+    int bound = ::bind(listenFd, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+    ::umask(previous);
+    if (bound != 0 || ::listen(listenFd, SOMAXCONN) != 0) {
+        YADA_TRACE(ERROR, IO, "Could not listen on " << socketPath << ": " << std::strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+void SessionServer::stop() {
+    stopping.store(true);
+    wake();
+}
+
+void SessionServer::wake() {
+    char byte = 0;
+    ssize_t written = ::write(wakePipe[1], &byte, 1);
+    (void)written;  // a full pipe already guarantees a wakeup
+}
+
+int SessionServer::run() {
+    if (!listen()) return 1;
+    for (size_t i = 0; i < workerCount; ++i) {
+        workers.emplace_back(&SessionServer::workerLoop, this);
+    }
+    YADA_TRACE(INFO, APP, "Serving on " << socketPath << " with " << workerCount << " workers");
+
+    std::vector<std::shared_ptr<Connection>> idle;
+    std::vector<pollfd> fds;
+    while (!stopping.load()) {
+        fds.clear();
+        fds.push_back({listenFd, POLLIN, 0});
+        fds.push_back({wakePipe[0], POLLIN, 0});
+        for (const auto& connection : idle) {
+            fds.push_back({connection->fd, POLLIN, 0});
+        }
+        if (::poll(fds.data(), fds.size(), -1) < 0) {
+            if (errno == EINTR) continue;
+            YADA_TRACE(ERROR, IO, "poll failed: " << std::strerror(errno));
+            break;
+        }
+
+        // Readable connections go to the workers; the rest stay idle
+        std::vector<std::shared_ptr<Connection>> stillIdle;
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            for (size_t i = 0; i < idle.size(); ++i) {
+                if (fds[i + 2].revents != 0) {
+                    readyConnections.push_back(idle[i]);
+                } else {
+                    stillIdle.push_back(idle[i]);
+                }
+            }
+        }
+        if (stillIdle.size() != idle.size()) queueReady.notify_all();
+        idle.swap(stillIdle);
+
+        if (fds[1].revents != 0) {
+            char buffer[64];
+            while (::read(wakePipe[0], buffer, sizeof(buffer)) > 0) {}
+            std::lock_guard<std::mutex> lock(queueMutex);
+            for (auto& connection : returnedConnections) {
+                if (connection->closing) {
+                    close(*connection);
+                } else {
+                    idle.push_back(std::move(connection));
+                }
+            }
+            returnedConnections.clear();
+        }
+
+        if (fds[0].revents != 0) {
+            int fd = ::accept4(listenFd, nullptr, nullptr, SOCK_CLOEXEC);
+            if (fd >= 0) {
+                timeval timeout = {SEND_TIMEOUT_MS / 1000, (SEND_TIMEOUT_MS % 1000) * 1000};
+                ::setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+                idle.push_back(std::make_shared<Connection>(fd, service));
+                YADA_TRACE(DETAIL, APP, "Accepted connection " << fd);
+            }
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        stopping.store(true);
+    }
+    queueReady.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    workers.clear();
+
+    // Workers are gone, so every connection is in exactly one of these lists
+    for (auto& connection : idle) close(*connection);
+    for (auto& connection : readyConnections) close(*connection);
+    for (auto& connection : returnedConnections) close(*connection);
+    readyConnections.clear();
+    returnedConnections.clear();
+    ::unlink(socketPath.c_str());
+    YADA_TRACE(INFO, APP, "Server on " << socketPath << " stopped");
+    return 0;
+}
+
+void SessionServer::workerLoop() {
+    while (true) {
+        std::shared_ptr<Connection> connection;
+        {
+            std::unique_lock<std::mutex> lock(queueMutex);
+            queueReady.wait(lock, [this] { return stopping.load() || !readyConnections.empty(); });
+            if (stopping.load()) return;
+            connection = std::move(readyConnections.front());
+            readyConnections.pop_front();
+        }
+
+        serve(*connection);
+
+        {
+            std::lock_guard<std::mutex> lock(queueMutex);
+            returnedConnections.push_back(std::move(connection));
+        }
+        wake();
+    }
+}
+
+void SessionServer::serve(Connection& connection) {
+    // poll() reported input, so this read does not block
+    char buffer[4096];
+    ssize_t received = ::recv(connection.fd, buffer, sizeof(buffer), 0);
+    if (received <= 0) {
+        connection.closing = true;
+        return;
+    }
+    connection.input.append(buffer, static_cast<size_t>(received));
+
+    size_t start = 0;
+    size_t end;
+    std::string response;
+    while ((end = connection.input.find('\n', start)) != std::string::npos) {
+        auto args = CommandInterpreter::tokenize(connection.input.substr(start, end - start));
+        start = end + 1;
+
+        std::ostringstream output;
+        bool ok = args.empty() || connection.interpreter.execute(args, output);
+        response += protocol::encodeResponse(output.str(), ok);
+    }
+    connection.input.erase(0, start);
+    if (connection.input.size() > protocol::MAX_REQUEST_BYTES) {
+        response += protocol::encodeResponse("Request too long.\n", false);
+        connection.closing = true;
+    }
+
+    const char* data = response.data();
+    size_t remaining = response.size();
+    while (remaining > 0) {
+        // Fails with EAGAIN once SEND_TIMEOUT_MS passes without progress
+        ssize_t sent = ::send(connection.fd, data, remaining, MSG_NOSIGNAL);
+        if (sent <= 0) {
+            connection.closing = true;
+            break;
+        }
+        data += sent;
+        remaining -= static_cast<size_t>(sent);
+    }
+}
+
+void SessionServer::close(Connection& connection) {
+    // Dropping a connection logs its user out, like leaving the menus
+    connection.interpreter.logout();
+    ::close(connection.fd);
+    YADA_TRACE(DETAIL, APP, "Closed connection " << connection.fd);
+}
@@ -1,6 +1,6 @@
 #include "user/user.h"
+#include "utils/trace.h"
 #include <sstream>
-#include <iostream>
 #include <cmath>
 
 User::User(const std::string& username, const std::string& passwordHash,
@@ -9,9 +9,7 @@ User::User(const std::string& username, const std::string& passwordHash,
     : username(username), passwordHash(passwordHash), gender(gender),
       height(height), age(age), weight(weight), activityLevel(activityLevel),
       calorieCalculationMethod("Mifflin-St Jeor") {
-    #ifdef DEBUG
-    std::cout << "DEBUG: Created User object with username: " << username << std::endl;
-    #endif
+    YADA_TRACE(VERBOSE, APP, "Created User object with username: " << username);
 }
 
 std::string User::getUsername() const { return username; }
@@ -79,9 +77,7 @@ void User::updateProfile(double height, int age, double weight, ActivityLevel le
     this->age = age;
     this->weight = weight;
     this->activityLevel = level;
-    #ifdef DEBUG
-    std::cout << "DEBUG: Updated profile for user: " << username << std::endl;
-    #endif
+    YADA_TRACE(DETAIL, APP, "Updated profile for user: " << username);
 }
 
 std::string User::toString() const {
@@ -108,26 +104,28 @@ std::string User::toString() const {
     return ss.str();
 }
 
-#ifdef DEBUG
 void User::debugPrint() const {
-    std::cout << "DEBUG: User Object:" << std::endl;
-    std::cout << "  Username: " << username << std::endl;
-    std::cout << "  Gender: " << (gender == Gender::MALE ? "Male" : 
-                                 gender == Gender::FEMALE ? "Female" : "Other") << std::endl;
-    std::cout << "  Height: " << height << " cm" << std::endl;
-    std::cout << "  Age: " << age << " years" << std::endl;
-    std::cout << "  Weight: " << weight << " kg" << std::endl;
-    std::cout << "  Activity Level: ";
+    if (!YADA_TRACE_ON(VERBOSE, APP)) return;
+
+    std::ostringstream out;
+    out << "User Object:\n";
+    out << "  Username: " << username << "\n";
+    out << "  Gender: " << (gender == Gender::MALE ? "Male" :
+                           gender == Gender::FEMALE ? "Female" : "Other") << "\n";
+    out << "  Height: " << height << " cm\n";
+    out << "  Age: " << age << " years\n";
+    out << "  Weight: " << weight << " kg\n";
+    out << "  Activity Level: ";
     switch (activityLevel) {
-        case ActivityLevel::SEDENTARY: std::cout << "Sedentary"; break;
-        case ActivityLevel::LIGHTLY_ACTIVE: std::cout << "Lightly Active"; break;
-        case ActivityLevel::MODERATELY_ACTIVE: std::cout << "Moderately Active"; break;
-        case ActivityLevel::VERY_ACTIVE: std::cout << "Very Active"; break;
-        case ActivityLevel::EXTRA_ACTIVE: std::cout << "Extra Active"; break;
+        case ActivityLevel::SEDENTARY: out << "Sedentary"; break;
+        case ActivityLevel::LIGHTLY_ACTIVE: out << "Lightly Active"; break;
+        case ActivityLevel::MODERATELY_ACTIVE: out << "Moderately Active"; break;
+        case ActivityLevel::VERY_ACTIVE: out << "Very Active"; break;
+        case ActivityLevel::EXTRA_ACTIVE: out << "Extra Active"; break;
     }
-    std::cout << std::endl;
-    std::cout << "  BMR: " << calculateBMR() << " calories" << std::endl;
-    std::cout << "  TDEE: " << calculateTDEE() << " calories" << std::endl;
-    std::cout << "  Target Calories: " << calculateTargetCalories() << " calories" << std::endl;
-}
-#endif 
\ No newline at end of file
+    out << "\n";
+    out << "  BMR: " << calculateBMR() << " calories\n";
+    out << "  TDEE: " << calculateTDEE() << " calories\n";
+    out << "  Target Calories: " << calculateTargetCalories() << " calories";
+    YADA_TRACE(VERBOSE, APP, out.str());
+}
\ No newline at end of file
@@ -0,0 +1,95 @@
+#include "utils/binary_io.h"
+#include <filesystem>
+#include <fstream>
+#include <system_error>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace utils {
+
+std::uint64_t checksum64(const char* data, std::size_t size) {
+    std::uint64_t hash = 14695981039346656037ull;
+    for (std::size_t i = 0; i < size; ++i) {
+        hash ^= static_cast<unsigned char>(data[i]);
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+#ifndef _WIN32
+namespace {
+
+// write() may stop short, so loop until everything is written or it fails
+bool writeAll(int fd, const char* data, std::size_t remaining) {
+    while (remaining > 0) {
+        ssize_t written = ::write(fd, data, remaining);
+        if (written <= 0) return false;
+        data += written;
+        remaining -= static_cast<std::size_t>(written);
+    }
+    return true;
+}
+
+} // namespace
+#endif
+
+bool writeFile(const std::string& path, const void* header, std::size_t headerSize, const std::string& payload) {
+#ifndef _WIN32
+    int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return false;
+    // The data must be on disk before a rename can make it visible
+    bool ok = writeAll(fd, static_cast<const char*>(header), headerSize)
+        && writeAll(fd, payload.data(), payload.size()) && ::fsync(fd) == 0;
+    return ::close(fd) == 0 && ok;
+#else
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) return false;
+    file.write(static_cast<const char*>(header), headerSize);
+    file.write(payload.data(), payload.size());
+    return static_cast<bool>(file.flush());
+#endif
+}
+
+bool appendFile(const std::string& path, const std::string& data) {
+#ifndef _WIN32
+    int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (fd < 0) return false;
+    bool ok = writeAll(fd, data.data(), data.size()) && ::fsync(fd) == 0;
+    return ::close(fd) == 0 && ok;
+#else
+    std::ofstream file(path, std::ios::binary | std::ios::app);
+    if (!file.is_open()) return false;
+    file << data;
+    return static_cast<bool>(file.flush());
+#endif
+}
+
+bool syncDirectory(const std::string& path) {
+#ifndef _WIN32
+    std::string directory = std::filesystem::path(path).parent_path().string();
+    int fd = ::open(directory.empty() ? "." : directory.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    bool ok = ::fsync(fd) == 0;
+    ::close(fd);
+    return ok;
+#else
+    (void)path;
+    return true;
+#endif
+}
+
+bool replaceFile(const std::string& path, const void* header, std::size_t headerSize, const std::string& payload) {
+    std::string tempPath = path + ".tmp";
+    if (!writeFile(tempPath, header, headerSize, payload)) {
+        std::error_code ignored;
+        std::filesystem::remove(tempPath, ignored);
+        return false;
+    }
+    std::error_code ec;
+    std::filesystem::rename(tempPath, path, ec);
+    return !ec && syncDirectory(path);
+}
+
+} // namespace utils
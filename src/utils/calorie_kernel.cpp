@@ -0,0 +1,167 @@
+#include "utils/calorie_kernel.h"
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define YADA_CALORIE_AVX2 1
+#include <immintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#define YADA_CALORIE_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace utils {
+
+namespace {
+
+// Reduces each day on its own with the same row kernel
+template <double (*Sum)(const double*, const std::uint32_t*, const std::int32_t*, std::size_t)>
+void sumEachDay(const double* perServing, const std::uint32_t* foods, const std::int32_t* servings,
+                const std::uint32_t* offsets, std::size_t dayCount, double* out) {
+    for (std::size_t day = 0; day < dayCount; ++day) {
+        out[day] = Sum(perServing, foods + offsets[day], servings + offsets[day], offsets[day + 1] - offsets[day]);
+    }
+}
+
+double sumScalar(const double* perServing, const std::uint32_t* foods, const std::int32_t* servings,
+                 std::size_t count) {
+    double total = 0.0;
+    for (std::size_t i = 0; i < count; ++i) {
+        total += perServing[foods[i]] * servings[i];
+    }
+    return total;
+}
+
+#if defined(YADA_CALORIE_AVX2)
+
+// Built for AVX2 regardless of the compiler flags; only called once the CPU
+// has been checked. The masked form with a zero source is used because the
+// plain gather starts from an undefined register.
+__attribute__((target("avx2")))
+inline __m256d multiplyAvx2(const double* perServing, const std::uint32_t* foods, const std::int32_t* servings) {
+    __m128i index = _mm_loadu_si128(reinterpret_cast<const __m128i*>(foods));
+    __m256d all = _mm256_castsi256_pd(_mm256_set1_epi64x(-1));
+    __m256d calories = _mm256_mask_i32gather_pd(_mm256_setzero_pd(), perServing, index, all, 8);
+    return _mm256_mul_pd(calories, _mm256_cvtepi32_pd(_mm_loadu_si128(reinterpret_cast<const __m128i*>(servings))));
+}
+
+__attribute__((target("avx2")))
+double sumAvx2(const double* perServing, const std::uint32_t* foods, const std::int32_t* servings,
+               std::size_t count) {
+    __m256d low = _mm256_setzero_pd();
+    __m256d high = _mm256_setzero_pd();
+    std::size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        low = _mm256_add_pd(low, multiplyAvx2(perServing, foods + i, servings + i));
+        high = _mm256_add_pd(high, multiplyAvx2(perServing, foods + i + 4, servings + i + 4));
+    }
+    if (i + 4 <= count) {
+        low = _mm256_add_pd(low, multiplyAvx2(perServing, foods + i, servings + i));
+        i += 4;
+    }
+
+    __m256d sum = _mm256_add_pd(low, high);
+    __m128d pair = _mm_add_pd(_mm256_castpd256_pd128(sum), _mm256_extractf128_pd(sum, 1));
+    double total = _mm_cvtsd_f64(_mm_add_sd(pair, _mm_unpackhi_pd(pair, pair)));
+    for (; i < count; ++i) {
+        total += perServing[foods[i]] * servings[i];
+    }
+    return total;
+}
+
+// Days are too short to fill vectors on their own, so the products for a
+// run of whole days are computed first and then summed day by day
+__attribute__((target("avx2")))
+void sumByDayAvx2(const double* perServing, const std::uint32_t* foods, const std::int32_t* servings,
+                  const std::uint32_t* offsets, std::size_t dayCount, double* out) {
+    constexpr std::size_t CHUNK_ROWS = 512;
+    alignas(32) double products[CHUNK_ROWS];
+    std::size_t day = 0;
+    while (day < dayCount) {
+        std::size_t begin = offsets[day];
+        std::size_t endDay = day;
+        while (endDay < dayCount && offsets[endDay + 1] - begin <= CHUNK_ROWS) ++endDay;
+        if (endDay == day) {
+            out[day] = sumAvx2(perServing, foods + begin, servings + begin, offsets[day + 1] - begin);
+            ++day;
+            continue;
+        }
+
+        std::size_t rows = offsets[endDay] - begin;
+        std::size_t row = 0;
+        for (; row + 4 <= rows; row += 4) {
+            _mm256_store_pd(products + row, multiplyAvx2(perServing, foods + begin + row, servings + begin + row));
+        }
+        for (; row < rows; ++row) {
+            products[row] = perServing[foods[begin + row]] * servings[begin + row];
+        }
+        static const std::int64_t LANE_MASKS[8] = {-1, -1, -1, -1, 0, 0, 0, 0};
+        for (; day < endDay; ++day) {
+            std::size_t i = offsets[day] - begin;
+            std::size_t end = offsets[day + 1] - begin;
+            __m256d sum = _mm256_setzero_pd();
+            for (; i + 4 <= end; i += 4) {
+                sum = _mm256_add_pd(sum, _mm256_loadu_pd(products + i));
+            }
+            __m256i mask = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(LANE_MASKS + 4 - (end - i)));
+            sum = _mm256_add_pd(sum, _mm256_maskload_pd(products + i, mask));
+            __m128d pair = _mm_add_pd(_mm256_castpd256_pd128(sum), _mm256_extractf128_pd(sum, 1));
+            out[day] = _mm_cvtsd_f64(_mm_add_sd(pair, _mm_unpackhi_pd(pair, pair)));
+        }
+    }
+}
+
+#elif defined(YADA_CALORIE_NEON)
+
+// NEON has no gather, so the table loads stay scalar and the multiply-adds are paired
+double sumNeon(const double* perServing, const std::uint32_t* foods, const std::int32_t* servings,
+               std::size_t count) {
+    float64x2_t low = vdupq_n_f64(0.0);
+    float64x2_t high = vdupq_n_f64(0.0);
+    std::size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        float64x2_t lowCalories = vcombine_f64(vld1_f64(perServing + foods[i]), vld1_f64(perServing + foods[i + 1]));
+        float64x2_t highCalories = vcombine_f64(vld1_f64(perServing + foods[i + 2]),
+                                                vld1_f64(perServing + foods[i + 3]));
+        int32x4_t quadServings = vld1q_s32(servings + i);
+        low = vfmaq_f64(low, lowCalories, vcvtq_f64_s64(vmovl_s32(vget_low_s32(quadServings))));
+        high = vfmaq_f64(high, highCalories, vcvtq_f64_s64(vmovl_s32(vget_high_s32(quadServings))));
+    }
+
+    double total = vaddvq_f64(vaddq_f64(low, high));
+    for (; i < count; ++i) {
+        total += perServing[foods[i]] * servings[i];
+    }
+    return total;
+}
+
+#endif
+
+const CalorieKernel SCALAR_KERNEL = {"scalar", sumScalar, sumEachDay<sumScalar>};
+#if defined(YADA_CALORIE_AVX2)
+const CalorieKernel AVX2_KERNEL = {"avx2", sumAvx2, sumByDayAvx2};
+#elif defined(YADA_CALORIE_NEON)
+const CalorieKernel NEON_KERNEL = {"neon", sumNeon, sumEachDay<sumNeon>};
+#endif
+
+const CalorieKernel& selectKernel() {
+#if defined(YADA_CALORIE_AVX2)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return AVX2_KERNEL;
+#elif defined(YADA_CALORIE_NEON)
+    // Advanced SIMD is part of every AArch64 CPU
+    return NEON_KERNEL;
+#endif
+    return SCALAR_KERNEL;
+}
+
+} // namespace
+
+const CalorieKernel& calorieKernel() {
+    static const CalorieKernel& selected = selectKernel();
+    return selected;
+}
+
+const CalorieKernel& scalarCalorieKernel() {
+    return SCALAR_KERNEL;
+}
+
+} // namespace utils
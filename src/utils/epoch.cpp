@@ -0,0 +1,69 @@
+#include "utils/epoch.h"
+#include <functional>
+#include <thread>
+
+namespace utils {
+
+namespace {
+
+thread_local int sectionDepth = 0;
+
+// Spread threads over the slots so uncontended entry takes one CAS
+std::size_t preferredSlot() {
+    thread_local std::size_t slot = std::hash<std::thread::id>()(std::this_thread::get_id());
+    return slot;
+}
+
+} // namespace
+
+EpochDomain::Section::Section(const EpochDomain* domain, std::size_t slot) : domain(domain), slot(slot) {
+    ++sectionDepth;
+}
+
+EpochDomain::Section::Section(Section&& other) noexcept : domain(other.domain), slot(other.slot) {
+    other.domain = nullptr;
+}
+
+EpochDomain::Section::~Section() {
+    if (!domain) return;
+    domain->slots[slot].epoch.store(IDLE, std::memory_order_release);
+    --sectionDepth;
+}
+
+EpochDomain::EpochDomain() : epoch(1) {
+    for (auto& slot : slots) {
+        slot.epoch.store(IDLE, std::memory_order_relaxed);
+    }
+}
+
+EpochDomain::Section EpochDomain::enter() const {
+    std::size_t start = preferredSlot();
+    while (true) {
+        for (std::size_t i = 0; i < SLOTS; ++i) {
+            std::size_t index = (start + i) % SLOTS;
+            std::uint64_t expected = IDLE;
+            // seq_cst: the slot must be visible before the caller loads the published pointer
+            if (slots[index].epoch.compare_exchange_strong(expected, epoch.load())) {
+                return Section(this, index);
+            }
+        }
+        std::this_thread::yield();
+    }
+}
+
+void EpochDomain::synchronize() {
+    // Sections that start from here on read the new epoch and therefore
+    // already see whatever was published before this call
+    std::uint64_t target = epoch.fetch_add(1) + 1;
+    for (auto& slot : slots) {
+        while (slot.epoch.load() < target) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+bool EpochDomain::inSection() {
+    return sectionDepth > 0;
+}
+
+} // namespace utils
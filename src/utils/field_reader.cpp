@@ -0,0 +1,62 @@
+#include "utils/field_reader.h"
+#include <charconv>
+
+namespace utils {
+
+std::string_view FieldReader::next(char delimiter) {
+    size_t end = rest.find(delimiter);
+    std::string_view field = rest.substr(0, end);
+    rest = end == std::string_view::npos ? std::string_view() : rest.substr(end + 1);
+    return field;
+}
+
+std::string_view FieldReader::remainder() {
+    std::string_view field = rest;
+    rest = std::string_view();
+    return field;
+}
+
+bool nextLine(std::string_view& text, std::string_view& line) {
+    if (text.empty()) return false;
+    size_t end = text.find('\n');
+    line = text.substr(0, end);
+    text = end == std::string_view::npos ? std::string_view() : text.substr(end + 1);
+    if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+    return true;
+}
+
+std::string_view trimView(std::string_view text) {
+    size_t first = text.find_first_not_of(" \t\n\r");
+    if (first == std::string_view::npos) return std::string_view();
+    size_t last = text.find_last_not_of(" \t\n\r");
+    return text.substr(first, last - first + 1);
+}
+
+bool parseDouble(std::string_view text, double& value) {
+    text = trimView(text);
+    if (!text.empty() && text.front() == '+') text.remove_prefix(1);
+    auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+    return error == std::errc() && end == text.data() + text.size() && !text.empty();
+}
+
+namespace {
+
+template <typename Integer>
+bool parseInteger(std::string_view text, Integer& value) {
+    text = trimView(text);
+    if (!text.empty() && text.front() == '+') text.remove_prefix(1);
+    auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+    return error == std::errc() && end == text.data() + text.size() && !text.empty();
+}
+
+} // namespace
+
+bool parseInt(std::string_view text, int& value) {
+    return parseInteger(text, value);
+}
+
+bool parseInt(std::string_view text, std::int64_t& value) {
+    return parseInteger(text, value);
+}
+
+} // namespace utils
@@ -0,0 +1,58 @@
+#include "utils/mapped_file.h"
+#include <fstream>
+#include <sstream>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace utils {
+
+MappedFile::MappedFile(const std::string& path) : mapping(nullptr), length(0), opened(false) {
+#ifndef _WIN32
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return;
+    struct stat info;
+    if (::fstat(fd, &info) == 0) {
+        opened = true;
+        length = static_cast<std::size_t>(info.st_size);
+        // mmap rejects empty files; an empty view needs no mapping anyway
+        if (length > 0) {
+            void* mapped = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapped != MAP_FAILED) {
+                mapping = mapped;
+                ::madvise(mapped, length, MADV_SEQUENTIAL);
+            } else {
+                opened = false;
+            }
+        }
+    }
+    ::close(fd);
+    if (opened || length == 0) return;
+#endif
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) return;
+    std::ostringstream contents;
+    contents << file.rdbuf();
+    buffer = contents.str();
+    length = buffer.size();
+    opened = true;
+}
+
+MappedFile::~MappedFile() {
+#ifndef _WIN32
+    if (mapping) ::munmap(mapping, length);
+#endif
+}
+
+bool MappedFile::isOpen() const {
+    return opened;
+}
+
+std::string_view MappedFile::contents() const {
+    return mapping ? std::string_view(static_cast<const char*>(mapping), length) : std::string_view(buffer);
+}
+
+} // namespace utils
@@ -0,0 +1,118 @@
+#include "utils/signature_kernel.h"
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define YADA_SIGNATURE_AVX2 1
+#include <immintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#define YADA_SIGNATURE_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace utils {
+
+namespace {
+
+// Every handle is written and the count only advances past survivors, so
+// the loop has no data-dependent branch
+std::size_t selectScalar(const std::uint64_t* signatures, std::size_t count, std::uint64_t query,
+                         std::uint32_t first, std::uint32_t* out) {
+    std::size_t found = 0;
+    for (std::size_t i = 0; i < count; ++i) {
+        out[found] = first + static_cast<std::uint32_t>(i);
+        found += (signatures[i] & query) == query;
+    }
+    return found;
+}
+
+// Writes the handles of the set bits of a 4-lane mask starting at `handle`
+inline std::size_t emitLanes(unsigned mask, std::uint32_t handle, std::uint32_t* out) {
+    std::size_t found = 0;
+    for (std::uint32_t lane = 0; lane < 4; ++lane) {
+        out[found] = handle + lane;
+        found += (mask >> lane) & 1;
+    }
+    return found;
+}
+
+#if defined(YADA_SIGNATURE_AVX2)
+
+// Built for AVX2 regardless of the compiler flags; only called once the CPU
+// has been checked. Most signatures fail, so eight are tested before any
+// handle is written.
+__attribute__((target("avx2")))
+inline unsigned testAvx2(const std::uint64_t* signatures, __m256i query) {
+    __m256i words = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(signatures));
+    __m256i hit = _mm256_cmpeq_epi64(_mm256_and_si256(words, query), query);
+    return static_cast<unsigned>(_mm256_movemask_pd(_mm256_castsi256_pd(hit)));
+}
+
+__attribute__((target("avx2")))
+std::size_t selectAvx2(const std::uint64_t* signatures, std::size_t count, std::uint64_t query,
+                       std::uint32_t first, std::uint32_t* out) {
+    __m256i wanted = _mm256_set1_epi64x(static_cast<long long>(query));
+    std::size_t found = 0;
+    std::size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        unsigned low = testAvx2(signatures + i, wanted);
+        unsigned high = testAvx2(signatures + i + 4, wanted);
+        if ((low | high) == 0) continue;
+        std::uint32_t handle = first + static_cast<std::uint32_t>(i);
+        found += emitLanes(low, handle, out + found);
+        found += emitLanes(high, handle + 4, out + found);
+    }
+    return found + selectScalar(signatures + i, count - i, query, first + static_cast<std::uint32_t>(i), out + found);
+}
+
+#elif defined(YADA_SIGNATURE_NEON)
+
+// Two lanes per register, so four signatures are tested per step
+std::size_t selectNeon(const std::uint64_t* signatures, std::size_t count, std::uint64_t query,
+                       std::uint32_t first, std::uint32_t* out) {
+    uint64x2_t wanted = vdupq_n_u64(query);
+    std::size_t found = 0;
+    std::size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        uint64x2_t low = vceqq_u64(vandq_u64(vld1q_u64(signatures + i), wanted), wanted);
+        uint64x2_t high = vceqq_u64(vandq_u64(vld1q_u64(signatures + i + 2), wanted), wanted);
+        if (vmaxvq_u32(vreinterpretq_u32_u64(vorrq_u64(low, high))) == 0) continue;
+        unsigned mask = static_cast<unsigned>(vgetq_lane_u64(low, 0) & 1)
+            | static_cast<unsigned>(vgetq_lane_u64(low, 1) & 2)
+            | static_cast<unsigned>(vgetq_lane_u64(high, 0) & 4)
+            | static_cast<unsigned>(vgetq_lane_u64(high, 1) & 8);
+        found += emitLanes(mask, first + static_cast<std::uint32_t>(i), out + found);
+    }
+    return found + selectScalar(signatures + i, count - i, query, first + static_cast<std::uint32_t>(i), out + found);
+}
+
+#endif
+
+const SignatureKernel SCALAR_KERNEL = {"scalar", selectScalar};
+#if defined(YADA_SIGNATURE_AVX2)
+const SignatureKernel AVX2_KERNEL = {"avx2", selectAvx2};
+#elif defined(YADA_SIGNATURE_NEON)
+const SignatureKernel NEON_KERNEL = {"neon", selectNeon};
+#endif
+
+const SignatureKernel& selectKernel() {
+#if defined(YADA_SIGNATURE_AVX2)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return AVX2_KERNEL;
+#elif defined(YADA_SIGNATURE_NEON)
+    // Advanced SIMD is part of every AArch64 CPU
+    return NEON_KERNEL;
+#endif
+    return SCALAR_KERNEL;
+}
+
+} // namespace
+
+const SignatureKernel& signatureKernel() {
+    static const SignatureKernel& selected = selectKernel();
+    return selected;
+}
+
+const SignatureKernel& scalarSignatureKernel() {
+    return SCALAR_KERNEL;
+}
+
+} // namespace utils
@@ -0,0 +1,145 @@
+#include "utils/trace.h"
+#include "utils/utils.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+
+namespace trace {
+
+namespace detail {
+    // Warnings and errors reach stderr unless the environment says otherwise
+    std::atomic<unsigned> categoryMask{~0u};
+    std::atomic<int> runtimeLevel{static_cast<int>(Level::WARNING)};
+}
+
+namespace {
+
+const size_t FLUSH_THRESHOLD = 16 * 1024;
+
+const char* levelName(Level level) {
+    switch (level) {
+        case Level::ERROR: return "ERROR";
+        case Level::WARNING: return "WARNING";
+        case Level::INFO: return "INFO";
+        case Level::DETAIL: return "DETAIL";
+        case Level::VERBOSE: return "VERBOSE";
+    }
+    return "?";
+}
+
+const char* categoryName(Category category) {
+    switch (category) {
+        case Category::DATABASE: return "database";
+        case Category::LOGGER: return "logger";
+        case Category::SEARCH: return "search";
+        case Category::IO: return "io";
+        case Category::APP: return "app";
+    }
+    return "?";
+}
+
+unsigned parseCategories(const std::string& list) {
+    unsigned mask = 0;
+    for (const auto& name : utils::splitString(utils::toLower(list), ',')) {
+        if (name == "all") mask = ~0u;
+        else if (name == "database") mask |= static_cast<unsigned>(Category::DATABASE);
+        else if (name == "logger") mask |= static_cast<unsigned>(Category::LOGGER);
+        else if (name == "search") mask |= static_cast<unsigned>(Category::SEARCH);
+        else if (name == "io") mask |= static_cast<unsigned>(Category::IO);
+        else if (name == "app") mask |= static_cast<unsigned>(Category::APP);
+    }
+    return mask;
+}
+
+// Owns the output buffer; flushed when full, on warnings/errors and at exit
+class Sink {
+private:
+    std::mutex mutex;
+    std::string buffer;
+    std::FILE* out;
+    bool ownsFile;
+    std::chrono::steady_clock::time_point start;
+
+    void flushLocked() {
+        if (buffer.empty()) return;
+        std::fwrite(buffer.data(), 1, buffer.size(), out);
+        std::fflush(out);
+        buffer.clear();
+    }
+
+public:
+    Sink() : out(stderr), ownsFile(false), start(std::chrono::steady_clock::now()) {
+        const char* categories = std::getenv("YADA_TRACE");
+        const char* level = std::getenv("YADA_TRACE_LEVEL");
+        const char* path = std::getenv("YADA_TRACE_FILE");
+        if (categories) {
+            // Naming categories asks for their informational output too
+            detail::categoryMask.store(parseCategories(categories));
+            detail::runtimeLevel.store(static_cast<int>(Level::INFO));
+        }
+        if (level) {
+            int value = std::atoi(level);
+            if (value >= static_cast<int>(Level::ERROR) && value <= static_cast<int>(Level::VERBOSE)) {
+                detail::runtimeLevel.store(value);
+            }
+        }
+        if (path) {
+            if (std::FILE* file = std::fopen(path, "a")) {
+                out = file;
+                ownsFile = true;
+            }
+        }
+    }
+
+    ~Sink() {
+        flushLocked();
+        if (ownsFile) std::fclose(out);
+    }
+
+    void write(Level level, Category category, const std::string& message) {
+        double elapsedMs = std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - start).count();
+        char prefix[64];
+        std::snprintf(prefix, sizeof(prefix), "[%10.3f ms] %s %s: ",
+                      elapsedMs, categoryName(category), levelName(level));
+
+        std::lock_guard<std::mutex> lock(mutex);
+        buffer += prefix;
+        buffer += message;
+        buffer += '\n';
+        if (buffer.size() >= FLUSH_THRESHOLD || level <= Level::WARNING) {
+            flushLocked();
+        }
+    }
+
+    void flush() {
+        std::lock_guard<std::mutex> lock(mutex);
+        flushLocked();
+    }
+};
+
+Sink& sink() {
+    static Sink instance;
+    return instance;
+}
+
+// Read the environment before main() so the runtime filter is in place from the start
+const bool sinkReady = (sink(), true);
+
+} // namespace
+
+void configure(const std::string& categories, Level level) {
+    detail::categoryMask.store(parseCategories(categories));
+    detail::runtimeLevel.store(static_cast<int>(level));
+}
+
+void write(Level level, Category category, const std::string& message) {
+    sink().write(level, category, message);
+}
+
+void flush() {
+    sink().flush();
+}
+
+} // namespace trace
@@ -63,6 +63,46 @@ std::time_t parseDate(const std::string& date) {
     return std::mktime(&tm);
 }
 
+int toDayNumber(const std::string& date) {
+    int year = 0, month = 0, day = 0;
+    auto digit = [&date](size_t i) { return date[i] - '0'; };
+    if (isCanonicalDate(date)) {
+        // Fast path for the YYYY-MM-DD form every stored date uses
+        year = digit(0) * 1000 + digit(1) * 100 + digit(2) * 10 + digit(3);
+        month = digit(5) * 10 + digit(6);
+        day = digit(8) * 10 + digit(9);
+    } else {
+        char sep1 = 0, sep2 = 0;
+        std::stringstream ss(date);
+        ss >> year >> sep1 >> month >> sep2 >> day;
+    }
+
+    // Civil-from-days inverse (H. Hinnant), with March as the first month
+    year -= month <= 2;
+    int era = (year >= 0 ? year : year - 399) / 400;
+    int yearOfEra = year - era * 400;
+    int dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    int dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    return era * 146097 + dayOfEra - 719468;
+}
+
+std::string fromDayNumber(int day) {
+    day += 719468;
+    int era = (day >= 0 ? day : day - 146096) / 146097;
+    int dayOfEra = day - era * 146097;
+    int yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+    int dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+    int monthIndex = (5 * dayOfYear + 2) / 153;
+    int dayOfMonth = dayOfYear - (153 * monthIndex + 2) / 5 + 1;
+    int month = monthIndex + (monthIndex < 10 ? 3 : -9);
+    int year = yearOfEra + era * 400 + (month <= 2);
+
+    std::stringstream ss;
+    ss << std::setfill('0') << std::setw(4) << year << "-"
+       << std::setw(2) << month << "-" << std::setw(2) << dayOfMonth;
+    return ss.str();
+}
+
 bool createDirectory(const std::string& path) {
     return std::filesystem::create_directories(path);
 }
@@ -77,11 +117,31 @@ std::string getFileExtension(const std::string& path) {
     return path.substr(pos);
 }
 
+bool isCanonicalDate(const std::string& date) {
+    if (date.size() != 10 || date[4] != '-' || date[7] != '-') return false;
+    for (size_t i : {0, 1, 2, 3, 5, 6, 8, 9}) {
+        if (!std::isdigit(static_cast<unsigned char>(date[i]))) return false;
+    }
+    auto digit = [&date](size_t i) { return date[i] - '0'; };
+    int year = digit(0) * 1000 + digit(1) * 100 + digit(2) * 10 + digit(3);
+    int month = digit(5) * 10 + digit(6);
+    int day = digit(8) * 10 + digit(9);
+    static const int monthDays[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    if (month < 1 || month > 12 || day < 1) return false;
+    bool leap = year % 4 == 0 && (year % 100 != 0 || year % 400 == 0);
+    return day <= monthDays[month - 1] + (month == 2 && leap);
+}
+
 bool isValidDate(const std::string& date) {
     std::tm tm = {};
     std::stringstream ss(date);
     ss >> std::get_time(&tm, "%Y-%m-%d");
-    return !ss.fail();
+    if (ss.fail()) return false;
+    // get_time takes any day up to 31, so the date must also name a real day
+    std::ostringstream fields;
+    fields << std::setfill('0') << std::setw(4) << tm.tm_year + 1900 << "-"
+           << std::setw(2) << tm.tm_mon + 1 << "-" << std::setw(2) << tm.tm_mday;
+    return isCanonicalDate(fields.str());
 }
 
 bool isValidNumber(const std::string& str) {
@@ -96,6 +156,10 @@ bool isValidUsername(const std::string& username) {
            [](char c) { return std::isalnum(c) || c == '_'; });
 }
 
+bool isValidFoodField(const std::string& text) {
+    return text.find_first_of("|,\r\n") == std::string::npos;
+}
+
 bool isValidPassword(const std::string& password) {
     // Password must be at least 8 characters long and contain at least one uppercase letter,
     // one lowercase letter, one number, and one special character
@@ -166,10 +230,4 @@ bool verifyPassword(const std::string& password, const std::string& hash) {
     return ss.str() == hash.substr(sizeof(salt) * 2);
 }
 
-#ifdef DEBUG
-void printDebug(const std::string& message) {
-    std::cout << "DEBUG: " << message << std::endl;
-}
-#endif
-
 } // namespace utils 
\ No newline at end of file